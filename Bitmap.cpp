@@ -4,10 +4,15 @@
 #include <WString.h>
 
 #include "Bitmap.h"
+#include "FileFont.h"
+#include "FlashReader.h"
+#include "GlyphCache.h"
 
 Bitmap::Bitmap(int width, int height)
-    : scr_width(width), scr_height(height), scr_stride((width + 7) / 8), frame_buffer(0), _font(0), textColor(White)
+    : scr_width(width), scr_height(height), scr_stride((width + 7) / 8), frame_buffer(0), _glyphCache(0), textColor(White), textScale(1), cursorX(0), cursorY(0), textWrap(true), utf8Count(0), utf8Need(0), _resolveCache(0), _numFallbackFonts(0)
 {
+    memset(&_fontInfo, 0, sizeof(_fontInfo));
+
     // Allocate memory for the framebuffer and clear it (1 = pixel off).
     unsigned int size = scr_stride * scr_height;
     frame_buffer = (uint8_t *)malloc(size);
@@ -19,6 +24,8 @@ Bitmap::~Bitmap()
 {
     if (frame_buffer)
         free(frame_buffer);
+    if (_resolveCache)
+        free(_resolveCache);
 }
 
 void Bitmap::clearScreen()
@@ -203,12 +210,22 @@ void Bitmap::drawFilledCircle(int centerX, int centerY, int radius, uint8_t colo
     drawCircle(centerX, centerY, radius, color, color);
 }
 
-void Bitmap::drawBitmap(int x, int y, const Bitmap &bitmap, uint8_t color)
+void Bitmap::drawBitmap(int x, int y, const Bitmap &bitmap, uint8_t color, uint8_t scale)
 {
     int bitmap_w = bitmap.getWidth();
     int bitmap_s = bitmap.getStride();
     int bitmap_h = bitmap.getHeight();
     uint8_t invColor = !color;
+    if (scale > 1)
+    {
+        // Bits that are 1 in the other bitmap are off, so write them in
+        // the inverse colour.
+        if (scale > BITMAP_MAX_SCALE)
+            scale = BITMAP_MAX_SCALE;
+        for (int by = 0; by < bitmap_h; ++by)
+            writeScaledRow(x, y + by * scale, bitmap.getFrameBuffer() + by * bitmap_s, bitmap_w, invColor, scale);
+        return;
+    }
     for (uint8_t by = 0; by < bitmap_h; ++by)
     {
         const uint8_t *line = bitmap.getFrameBuffer() + by * bitmap_s;
@@ -230,31 +247,24 @@ void Bitmap::drawBitmap(int x, int y, const Bitmap &bitmap, uint8_t color)
     }
 }
 
-void Bitmap::drawBitmap(int x, int y, PGM_VOID_P bitmap, uint8_t color)
+void Bitmap::drawBitmap(int x, int y, PGM_VOID_P bitmap, uint8_t color, uint8_t scale)
 {
-    uint8_t bitmap_w = pgm_read_byte(bitmap);
+    // Each row of the bitmap is copied out of flash and then written in
+    // one go, as the layout is the same as the frame buffer.
+    FlashReader reader(bitmap);
+    uint8_t bitmap_w = reader.readByte();
     uint8_t bitmap_s = (bitmap_w + 7) >> 3;
-    uint8_t bitmap_h = pgm_read_byte(bitmap + 1);
-    uint8_t invColor = !color;
+    uint8_t bitmap_h = reader.readByte();
+    uint8_t row[32];
+    if (scale > BITMAP_MAX_SCALE)
+        scale = BITMAP_MAX_SCALE;
     for (uint8_t by = 0; by < bitmap_h; ++by)
     {
-        const uint8_t *line = ((const uint8_t *)bitmap) + 2 + by * bitmap_s;
-        uint8_t mask = 0x80;
-        uint8_t value = pgm_read_byte(line);
-        for (uint8_t bx = 0; bx < bitmap_w; ++bx)
-        {
-            if (value & mask)
-                setPixel(x + bx, y + by, color);
-            else
-                setPixel(x + bx, y + by, invColor);
-            mask >>= 1;
-            if (!mask)
-            {
-                mask = 0x80;
-                ++line;
-                value = pgm_read_byte(line);
-            }
-        }
+        reader.readBytes(row, bitmap_s);
+        if (scale > 1)
+            writeScaledRow(x, y + by * scale, row, bitmap_w, color, scale);
+        else
+            writeRow(x, y + by, row, bitmap_w, color);
     }
 }
 
@@ -268,32 +278,406 @@ void Bitmap::drawInvertedBitmap(int x, int y, PGM_VOID_P bitmap)
     drawBitmap(x, y, bitmap, Black);
 }
 
-void Bitmap::setFont(const uint8_t *font)
+#define GLYPH_CODE_NONE 0xFFFFFFFFUL
+
+// Fonts are read from PROGMEM, or through the page cache of a FileFont,
+// at an offset from the start of the font.
+static inline uint8_t readFontByte(const FontInfo &info, uint32_t offset)
+{
+    if (info.file)
+        return info.file->readByte(offset);
+    return pgm_read_byte(info.font + offset);
+}
+
+// Multi-byte values in fonts are little-endian and may not be aligned.
+static inline uint16_t readLE16(const FontInfo &info, uint32_t offset)
+{
+    return readFontByte(info, offset) | (readFontByte(info, offset + 1) << 8);
+}
+
+static inline uint32_t readLE32(const FontInfo &info, uint32_t offset)
+{
+    return readLE16(info, offset) | (((uint32_t)readLE16(info, offset + 2)) << 16);
+}
+
+// Returns the number of bits needed to hold values up to "value".
+static uint8_t bitLength(uint8_t value)
+{
+    uint8_t count = 0;
+    while (value)
+    {
+        ++count;
+        value >>= 1;
+    }
+    return count;
+}
+
+// Box around the pixels of a packed glyph.
+struct PackedBox
+{
+    uint8_t top;
+    uint8_t height;
+    uint8_t left;
+    uint8_t width;
+};
+
+// Reads the box at the start of a packed glyph, leaving "bits" at the
+// first pixel.
+template <typename Reader>
+static void readPackedBox(BitReader<Reader> &bits, uint8_t font_height, uint8_t char_width, PackedBox &box)
+{
+    uint8_t heightBits = bitLength(font_height);
+    uint8_t widthBits = bitLength(char_width);
+    box.top = bits.readBits(heightBits);
+    box.height = bits.readBits(heightBits);
+    box.left = bits.readBits(widthBits);
+    box.width = bits.readBits(widthBits);
+}
+
+// ORs the next "count" bits of a packed glyph into "row" starting at bit
+// "offset".
+template <typename Reader>
+static void unpackBits(BitReader<Reader> &bits, int count, uint8_t *row, int offset)
+{
+    while (count > 0)
+    {
+        uint8_t n = (count > 8) ? 8 : count;
+        uint8_t value = bits.readBits(n) << (8 - n);
+        uint8_t *dest = row + (offset >> 3);
+        uint8_t shift = offset & 0x07;
+        dest[0] |= value >> shift;
+        if ((shift + n) > 8)
+            dest[1] |= value << (8 - shift);
+        offset += n;
+        count -= n;
+    }
+}
+
+// Returns the index of the glyph for "code" in a font, or -1 if the font
+// does not contain the character.
+static int findGlyphIndex(const FontInfo &info, uint32_t code)
+{
+    if (info.map)
+    {
+        // Fonts cut down to a set of characters look the glyph up directly.
+        if (code < info.firstChar || code >= ((uint32_t)info.firstChar + info.mapCount))
+            return -1;
+        uint8_t index = readFontByte(info, info.map + (code - info.firstChar));
+        if (index >= info.glyphCount)
+            return -1; // FONT_MAP_NONE
+        return index;
+    }
+    if (!info.ranges)
+    {
+        if (code < info.firstChar || code >= ((uint32_t)info.firstChar + info.glyphCount))
+            return -1;
+        return code - info.firstChar;
+    }
+
+    // Binary search the ranges, which are sorted by first code point.
+    int low = 0;
+    int high = info.rangeCount - 1;
+    while (low <= high)
+    {
+        int mid = (low + high) >> 1;
+        uint32_t range = info.ranges + mid * sizeof(FontRange);
+        uint32_t first = readLE32(info, range);
+        if (code < first)
+        {
+            high = mid - 1;
+        }
+        else if (code >= first + readLE16(info, range + 4))
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            return readLE16(info, range + 6) + (code - first);
+        }
+    }
+    return -1;
+}
+
+// Offsets of each glyph's image within a variable-width font, built the
+// first time the font is selected and kept for the life of the program.
+struct FontIndex
+{
+    const uint8_t *font;
+    FontIndex *next;
+    uint16_t offsets[1];
+};
+
+static FontIndex *fontIndexes = 0;
+
+static const uint16_t *getFontIndex(const uint8_t *font)
 {
-    _font = (uint8_t *)font;
+    FontIndex *index;
+    for (index = fontIndexes; index; index = index->next)
+    {
+        if (index->font == font)
+            return index->offsets;
+    }
+    FlashReader reader(font);
+    reader.skip(3);
+    uint8_t heightBytes = (reader.readByte() + 7) >> 3;
+    reader.skip(1);
+    uint8_t char_count = reader.readByte();
+    index = (FontIndex *)malloc(sizeof(FontIndex) + sizeof(uint16_t) * char_count);
+    if (!index)
+        return 0; // Fall back to scanning the width table.
+    index->font = font;
+    index->next = fontIndexes;
+    uint16_t offset = 6 + char_count;
+    for (uint8_t temp = 0; temp < char_count; ++temp)
+    {
+        index->offsets[temp] = offset;
+        offset += reader.readByte() * heightBytes;
+    }
+    index->offsets[char_count] = offset;
+    fontIndexes = index;
+    return index->offsets;
 }
 
-#define Font_IsFixed(font) (pgm_read_byte((font)) == 0 && \
-                            pgm_read_byte((font) + 1) == 0)
-#define Font_getWidth(font) (pgm_read_byte((font) + 2))
-#define Font_getHeight(font) (pgm_read_byte((font) + 3))
-#define Font_getFirstChar(font) (pgm_read_byte((font) + 4))
-#define Font_getCharCount(font) (pgm_read_byte((font) + 5))
+// Decodes the header and tables of "font", or of the font in "file", into
+// "info".  Returns false, leaving "info" empty, if there is no font or its
+// header is invalid.
+static bool parseFont(const uint8_t *font, FileFont *file, FontInfo &info)
+{
+    memset(&info, 0, sizeof(info));
+    if (file)
+        font = (const uint8_t *)file;
+    else if (!font)
+        return false;
+    info.font = font;
+    info.file = file;
+
+    // Both kinds of header are read in one go.  FontCreator headers are
+    // only six bytes, but are always followed by more of the font.
+    uint8_t header[sizeof(ExtFontHeader)];
+    if (file)
+    {
+        FileFontReader reader(file, 0);
+        reader.readBytes(header, sizeof(header));
+    }
+    else
+    {
+        FlashReader reader(font);
+        reader.readBytes(header, sizeof(header));
+    }
+    info.width = header[2];
+    info.height = header[3];
+    if (header[0] == FONT_EXT_MARKER)
+    {
+        info.encoding = header[1];
+        info.flags = header[6];
+        info.baseline = header[7];
+        uint32_t posn = sizeof(ExtFontHeader);
+        if (info.flags & FONT_FLAG_RANGES)
+        {
+            info.glyphCount = readLE16(info, posn);
+            info.rangeCount = readLE16(info, posn + 2);
+            info.ranges = posn + 4;
+            posn = info.ranges + info.rangeCount * sizeof(FontRange);
+        }
+        else if (info.flags & FONT_FLAG_MAP)
+        {
+            info.firstChar = header[4];
+            info.mapCount = header[5];
+            info.glyphCount = readFontByte(info, posn);
+            info.map = posn + 1;
+            posn = info.map + info.mapCount;
+        }
+        else
+        {
+            info.firstChar = header[4];
+            info.glyphCount = header[5];
+        }
+        info.offsets = posn;
+        info.widths = posn + (info.glyphCount + 1) * 2;
+
+        // The first glyph starts straight after the width table.
+        if (info.encoding > FONT_ENCODING_PACKED || !info.height || !info.glyphCount ||
+            ((info.flags & FONT_FLAG_RANGES) && !info.rangeCount) ||
+            ((info.flags & FONT_FLAG_MAP) && !info.mapCount) ||
+            readLE16(info, info.offsets) != info.widths + info.glyphCount)
+        {
+            memset(&info, 0, sizeof(info));
+            return false;
+        }
+    }
+    else if (file)
+    {
+        // FontCreator fonts have no glyph offsets, so must be in PROGMEM.
+        memset(&info, 0, sizeof(info));
+        return false;
+    }
+    else
+    {
+        info.encoding = FONT_ENCODING_COLUMN_MAJOR;
+        info.firstChar = header[4];
+        info.glyphCount = header[5];
+        bool fixed = header[0] == 0 && header[1] == 0;
+        if (!info.height || !info.glyphCount || (fixed && !info.width))
+        {
+            memset(&info, 0, sizeof(info));
+            return false;
+        }
+        if (fixed)
+        {
+            info.flags = FONT_FLAG_FIXED_WIDTH;
+            info.data = 6;
+        }
+        else
+        {
+            info.widths = 6;
+            info.data = 6 + info.glyphCount;
+            info.index = getFontIndex(font);
+        }
+    }
+    return true;
+}
+
+bool Bitmap::setFont(const uint8_t *font)
+{
+    return loadFont(font, 0);
+}
+
+bool Bitmap::setFont(FileFont &font)
+{
+    return loadFont(0, &font);
+}
+
+bool Bitmap::addFallbackFont(const uint8_t *font)
+{
+    return loadFallbackFont(font, 0);
+}
+
+bool Bitmap::addFallbackFont(FileFont &font)
+{
+    return loadFallbackFont(0, &font);
+}
+
+bool Bitmap::loadFont(const uint8_t *font, FileFont *file)
+{
+    // Fonts with an invalid header are not selected, so nothing is drawn
+    // rather than garbage.
+    bool valid = parseFont(font, file, _fontInfo);
+    if (_fontInfo.ranges)
+        allocResolveCache();
+    clearResolveCache();
+    updateSpaceWidth();
+    return valid;
+}
+
+bool Bitmap::loadFallbackFont(const uint8_t *font, FileFont *file)
+{
+    if (_numFallbackFonts >= BITMAP_MAX_FALLBACK_FONTS)
+        return false;
+    if (!parseFont(font, file, _fallbackFonts[_numFallbackFonts]))
+        return false;
+    ++_numFallbackFonts;
+    allocResolveCache();
+    clearResolveCache();
+    updateSpaceWidth();
+    return true;
+}
+
+void Bitmap::clearFallbackFonts()
+{
+    _numFallbackFonts = 0;
+    clearResolveCache();
+    updateSpaceWidth();
+}
+
+void Bitmap::updateSpaceWidth()
+{
+    // Font may not have space, or it is zero-width, so use the width of
+    // 'n' instead.  Fonts without 'n' use their own space character.
+    Glyph glyph;
+    if (_fontInfo.font && (resolveGlyph('n', glyph) || resolveGlyph(' ', glyph)))
+        _fontInfo.spaceWidth = glyph.width;
+    else
+        _fontInfo.spaceWidth = 0;
+}
+
+void Bitmap::allocResolveCache()
+{
+    if (!_resolveCache)
+        _resolveCache = (ResolvedGlyph *)malloc(sizeof(ResolvedGlyph) * BITMAP_RESOLVE_CACHE_SIZE);
+}
+
+void Bitmap::clearResolveCache()
+{
+    if (!_resolveCache)
+        return;
+    for (uint8_t temp = 0; temp < BITMAP_RESOLVE_CACHE_SIZE; ++temp)
+        _resolveCache[temp].code = GLYPH_CODE_NONE;
+}
+
+// Reads the characters of a string in RAM.
+class StringReader
+{
+public:
+    explicit StringReader(const char *str) : ptr(str) {}
+
+    char next() { return *ptr++; }
+    const char *position() const { return ptr; }
+
+private:
+    const char *ptr;
+};
+
+// Decodes the next UTF-8 code point from "reader".  "len" is the number of
+// bytes left, or -1 if the string is NUL-terminated.  Bytes that do not
+// start a valid UTF-8 sequence are returned as Latin-1 characters so that
+// existing 8-bit text continues to work.
+template <typename Reader>
+static uint32_t nextCodePoint(Reader &reader, int &len)
+{
+    uint8_t ch = (uint8_t)reader.next();
+    if (len > 0)
+        --len;
+    if (ch < 0xC2 || ch > 0xF4)
+        return ch;
+    uint8_t extra = ch >= 0xF0 ? 3 : (ch >= 0xE0 ? 2 : 1);
+    if (len >= 0 && len < extra)
+        return ch;
+    Reader peek = reader;
+    uint32_t code = ch & (0x3F >> extra);
+    for (uint8_t temp = 0; temp < extra; ++temp)
+    {
+        uint8_t next = (uint8_t)peek.next();
+        if ((next & 0xC0) != 0x80)
+            return ch;
+        code = (code << 6) | (next & 0x3F);
+    }
+    reader = peek;
+    if (len > 0)
+        len -= extra;
+    return code;
+}
+
+uint32_t Bitmap::decodeUtf8(const char *&str, int &len)
+{
+    StringReader reader(str);
+    uint32_t code = nextCodePoint(reader, len);
+    str = reader.position();
+    return code;
+}
 
 void Bitmap::drawString(int x, int y, const char *str, int len)
 {
-    if (!_font)
+    if (!_fontInfo.font)
         return;
-    uint8_t font_height = Font_getHeight(_font);
+    int font_height = getTextHeight();
     if (len < 0)
         len = strlen(str);
-    while (len-- > 0)
+    StringReader reader(str);
+    while (len > 0)
     {
-        x += drawChar(x, y, *str++);
-        //if (len > 0) {
-        fill(x, y, 1, font_height, !textColor);
-        ++x;
-        //}
+        x += drawCodePoint(x, y, nextCodePoint(reader, len));
+        fill(x, y, textScale, font_height, !textColor);
+        x += textScale;
         if (x >= scr_width)
             break;
     }
@@ -301,18 +685,26 @@ void Bitmap::drawString(int x, int y, const char *str, int len)
 
 void Bitmap::drawString(int x, int y, const String &str, int start, int len)
 {
-    if (!_font)
-        return;
-    uint8_t font_height = Font_getHeight(_font);
     if (len < 0)
         len = str.length() - start;
-    while (len-- > 0)
+    drawText(x, y, str.c_str() + start, len);
+}
+
+void Bitmap::drawText(int x, int y, const char *str, int len)
+{
+    // Like drawString() but without the gap after the last character, as
+    // for a String.
+    if (!_fontInfo.font)
+        return;
+    int font_height = getTextHeight();
+    StringReader reader(str);
+    while (len > 0)
     {
-        x += drawChar(x, y, str[start++]);
+        x += drawCodePoint(x, y, nextCodePoint(reader, len));
         if (len > 0)
         {
-            fill(x, y, 1, font_height, !textColor);
-            ++x;
+            fill(x, y, textScale, font_height, !textColor);
+            x += textScale;
         }
         if (x >= scr_width)
             break;
@@ -321,76 +713,363 @@ void Bitmap::drawString(int x, int y, const String &str, int start, int len)
 
 void Bitmap::drawString_P(int x, int y, PGM_P str, int len)
 {
-    // if (!str) return;
-    if (len < 0)
-        len = strlen_P((PGM_P)str);
-    char buff[64];
-    memcpy_P(buff, str, len);
-    drawString(x, y, buff, len);
+    // Characters are decoded straight from flash as they are drawn, so
+    // there is no limit on the length of the string.
+    if (!_fontInfo.font)
+        return;
+    int font_height = getTextHeight();
+    FlashReader reader(str);
+    while (len != 0)
+    {
+        uint32_t code = nextCodePoint(reader, len);
+        if (!code && len < 0)
+            break;
+        x += drawCodePoint(x, y, code);
+        fill(x, y, textScale, font_height, !textColor);
+        x += textScale;
+        if (x >= scr_width)
+            break;
+    }
 }
 
 void Bitmap::drawString_P(int x, int y, const __FlashStringHelper *str, int len)
 {
-    // if (!str) return;
-    if (len < 0)
-        len = strlen_P((PGM_P)str);
-    char buff[64];
-    memcpy_P(buff, str, len);
-    drawString(x, y, buff, len);
+    drawString_P(x, y, (PGM_P)str, len);
+}
+
+void Bitmap::setTextScale(uint8_t scale)
+{
+    if (scale < 1)
+        scale = 1;
+    else if (scale > BITMAP_MAX_SCALE)
+        scale = BITMAP_MAX_SCALE;
+    textScale = scale;
+}
+
+void Bitmap::setCursor(int x, int y)
+{
+    cursorX = x;
+    cursorY = y;
+    utf8Count = 0;
+}
+
+size_t Bitmap::write(uint8_t ch)
+{
+    // Bytes arrive one at a time from Print, so UTF-8 sequences are
+    // collected here until they are complete.
+    if (utf8Count)
+    {
+        if ((ch & 0xC0) == 0x80)
+        {
+            utf8Buf[utf8Count++] = ch;
+            if (utf8Count < utf8Need)
+                return 1;
+            const char *str = utf8Buf;
+            int len = utf8Count;
+            utf8Count = 0;
+            while (len > 0)
+                printCodePoint(decodeUtf8(str, len));
+            return 1;
+        }
+
+        // The sequence was cut short, so draw its bytes as Latin-1.
+        for (uint8_t temp = 0; temp < utf8Count; ++temp)
+            printCodePoint((uint8_t)utf8Buf[temp]);
+        utf8Count = 0;
+    }
+    if (ch >= 0xC0 && ch <= 0xF7)
+    {
+        utf8Buf[0] = ch;
+        utf8Count = 1;
+        utf8Need = (ch >= 0xF0) ? 4 : ((ch >= 0xE0) ? 3 : 2);
+        return 1;
+    }
+    printCodePoint(ch);
+    return 1;
+}
+
+void Bitmap::printCodePoint(uint32_t code)
+{
+    // Draw at the cursor like drawString(), wrapping to the next line at
+    // the right edge if wrapping is on.
+    if (!_fontInfo.font)
+        return;
+    int font_height = getTextHeight();
+    if (code == '\n')
+    {
+        cursorX = 0;
+        cursorY += font_height + textScale;
+        return;
+    }
+    if (code == '\r')
+        return;
+    Glyph glyph;
+    int width;
+    if (code == ' ')
+    {
+        glyph.font = 0;
+        width = getSpaceWidth() * textScale;
+    }
+    else if (resolveGlyph(code, glyph))
+    {
+        width = glyph.width * textScale;
+    }
+    else
+    {
+        glyph.font = 0;
+        width = 0;
+    }
+    if (textWrap && cursorX > 0 && (cursorX + width) > scr_width)
+    {
+        cursorX = 0;
+        cursorY += font_height + textScale;
+    }
+    if (glyph.font)
+        drawGlyph(cursorX, cursorY, glyph);
+    else
+        fill(cursorX, cursorY, width, font_height, !textColor);
+    cursorX += width;
+    fill(cursorX, cursorY, textScale, font_height, !textColor);
+    cursorX += textScale;
 }
 
 int Bitmap::drawChar(int x, int y, char ch)
 {
-    uint8_t font_height = Font_getHeight(_font);
-    if (ch == ' ')
+    return drawCodePoint(x, y, (uint8_t)ch);
+}
+
+int Bitmap::drawCodePoint(int x, int y, uint32_t code)
+{
+    if (!_fontInfo.font)
+        return 0;
+    if (code == ' ')
     {
-        // Font may not have space, or it is zero-width.  Calculate
-        // the real size and fill the space.
-        int spaceWidth = getCharWidth('n');
-        fill(x, y, spaceWidth, font_height, !textColor);
+        int spaceWidth = getSpaceWidth() * textScale;
+        fill(x, y, spaceWidth, getTextHeight(), !textColor);
         return spaceWidth;
     }
-    uint8_t first_char = Font_getFirstChar(_font);
-    uint8_t char_count = Font_getCharCount(_font);
-    uint8_t char_index = (uint8_t)ch;
-    if (char_index < first_char || char_index >= (first_char + char_count))
+    Glyph glyph;
+    if (!resolveGlyph(code, glyph))
         return 0;
-    char_index -= first_char;
-    uint8_t heightBytes = (font_height + 7) >> 3;
+    return drawGlyph(x, y, glyph);
+}
 
-    uint8_t char_width;
-    const uint8_t *image;
-    if (Font_IsFixed(_font))
+bool Bitmap::resolveGlyph(uint32_t code, Glyph &glyph) const
+{
+    // Characters in the primary font's single range need no searching.
+    int index;
+    if (!_fontInfo.ranges)
     {
-        // Fixed-width font.
-        char_width = Font_getWidth(_font);
-        image = ((const uint8_t *)_font) + 6 + char_index * heightBytes * char_width;
+        index = findGlyphIndex(_fontInfo, code);
+        if (index >= 0)
+        {
+            findGlyph(_fontInfo, index, glyph);
+            return true;
+        }
+        if (!_numFallbackFonts)
+            return false;
     }
-    else
+
+    // Otherwise search the ranges of the primary font and then the
+    // fallback fonts, remembering the answer for next time.
+    ResolvedGlyph *entry = 0;
+    if (_resolveCache)
     {
-        // Variable-width font.
-        char_width = pgm_read_byte(_font + 6 + char_index);
-        image = ((const uint8_t *)_font) + 6 + char_count;
-        for (uint8_t temp = 0; temp < char_index; ++temp)
+        entry = &(_resolveCache[code & (BITMAP_RESOLVE_CACHE_SIZE - 1)]);
+        if (entry->code == code)
         {
-            // Scan through all previous characters to find the starting
-            // location for this one.
-            image += pgm_read_byte(_font + 6 + temp) * heightBytes;
+            glyph = entry->glyph;
+            return glyph.font != 0;
         }
     }
+    glyph.font = 0;
+    for (uint8_t temp = 0; temp <= _numFallbackFonts; ++temp)
+    {
+        const FontInfo &info = temp ? _fallbackFonts[temp - 1] : _fontInfo;
+        index = findGlyphIndex(info, code);
+        if (index >= 0)
+        {
+            findGlyph(info, index, glyph);
+            break;
+        }
+    }
+    if (entry)
+    {
+        entry->code = code;
+        entry->glyph = glyph;
+    }
+    return glyph.font != 0;
+}
+
+void Bitmap::findGlyph(const FontInfo &info, uint16_t index, Glyph &glyph) const
+{
+    // A glyph in the glyph cache is drawn from there, so its size is all
+    // that is needed and the font itself is not read.
+    if (_glyphCache && _glyphCache->lookup(info.font, index, glyph.width, glyph.height))
+    {
+        glyph.font = info.font;
+        glyph.index = index;
+        glyph.encoding = info.encoding;
+        glyph.file = info.file;
+        glyph.image = 0;
+        glyph.hasImage = false;
+        return;
+    }
+    loadGlyph(info, index, glyph);
+}
+
+bool Bitmap::loadGlyphImage(Glyph &glyph) const
+{
+    // Finds the image of a glyph from findGlyph() that has to be drawn
+    // from the font after all, such as one evicted from the cache since.
+    if (glyph.hasImage)
+        return true;
+    for (uint8_t temp = 0; temp <= _numFallbackFonts; ++temp)
+    {
+        const FontInfo &info = temp ? _fallbackFonts[temp - 1] : _fontInfo;
+        if (info.font == glyph.font && info.file == glyph.file)
+        {
+            loadGlyph(info, glyph.index, glyph);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Bitmap::loadGlyph(const FontInfo &info, uint16_t index, Glyph &glyph)
+{
+    glyph.font = info.font;
+    glyph.index = index;
+    glyph.height = info.height;
+    glyph.encoding = info.encoding;
+    glyph.file = info.file;
+    glyph.hasImage = true;
+    if (info.offsets)
+    {
+        glyph.width = readFontByte(info, info.widths + index);
+        glyph.image = readLE16(info, info.offsets + index * 2);
+        return;
+    }
+    uint8_t heightBytes = (info.height + 7) >> 3;
+    if (!info.widths)
+    {
+        // Fixed-width font.
+        glyph.width = info.width;
+        glyph.image = info.data + (uint32_t)index * heightBytes * info.width;
+        return;
+    }
+
+    // Variable-width font.
+    glyph.width = readFontByte(info, info.widths + index);
+    if (info.index)
+    {
+        glyph.image = info.index[index];
+        return;
+    }
+    uint32_t image = info.data;
+    FlashReader reader(info.font + info.widths);
+    for (uint16_t temp = 0; temp < index; ++temp)
+    {
+        // Scan through all previous characters to find the starting
+        // location for this one.
+        image += reader.readByte() * heightBytes;
+    }
+    glyph.image = image;
+}
+
+int Bitmap::drawGlyph(int x, int y, const Glyph &glyph)
+{
+    int font_height = glyph.height * textScale;
+    int char_width = glyph.width * textScale;
     if ((x + char_width) <= 0 || (y + font_height) <= 0)
         return char_width; // Character is off the top or left of the screen.
+    if (_glyphCache && drawCachedGlyph(x, y, glyph))
+        return char_width;
+    Glyph loaded = glyph;
+    if (!loadGlyphImage(loaded))
+        return char_width;
+    if (loaded.file)
+    {
+        FileFontReader reader(loaded.file, loaded.image);
+        drawGlyphImage(reader, x, y, loaded);
+    }
+    else
+    {
+        FlashReader reader(loaded.font + loaded.image);
+        drawGlyphImage(reader, x, y, loaded);
+    }
+    return char_width;
+}
+
+template <typename Reader>
+void Bitmap::drawGlyphImage(Reader &reader, int x, int y, const Glyph &glyph)
+{
+    if (textScale > 1)
+    {
+        drawScaledGlyphImage(reader, x, y, glyph);
+        return;
+    }
+    uint8_t font_height = glyph.height;
+    uint8_t char_width = glyph.width;
+    if (glyph.encoding != FONT_ENCODING_COLUMN_MAJOR)
+    {
+        // Row-major glyphs have the same layout as the frame buffer, so
+        // each row of the glyph can be written with a few shifts and masks.
+        uint8_t stride = (char_width + 7) >> 3;
+        uint8_t row[32];
+        if (glyph.encoding == FONT_ENCODING_PACKED)
+        {
+            // Unpack a row of the box at a time into a blank glyph row.
+            BitReader<Reader> bits(reader);
+            PackedBox box;
+            readPackedBox(bits, font_height, char_width, box);
+            for (uint8_t cy = 0; cy < font_height; ++cy)
+            {
+                int posn = y + cy;
+                if (posn >= scr_height)
+                    break;
+                bool inBox = (uint8_t)(cy - box.top) < box.height;
+                if (posn >= 0)
+                {
+                    memset(row, 0, stride);
+                    if (inBox)
+                        unpackBits(bits, box.width, row, box.left);
+                    writeRow(x, posn, row, char_width, textColor);
+                }
+                else if (inBox)
+                {
+                    bits.skipBits(box.width);
+                }
+            }
+            return;
+        }
+        if (y < 0)
+            reader.skip(-y * stride);
+        for (uint8_t cy = (y < 0) ? -y : 0; cy < font_height; ++cy)
+        {
+            int posn = y + cy;
+            if (posn >= scr_height)
+                break;
+            reader.readBytes(row, stride);
+            writeRow(x, posn, row, char_width, textColor);
+        }
+        return;
+    }
+
+    // Column-major glyphs are stored a band of 8 rows at a time, so read
+    // the bytes in order across each band.
+    uint8_t heightBytes = (font_height + 7) >> 3;
     uint8_t invColor = !textColor;
-    for (uint8_t cx = 0; cx < char_width; ++cx)
+    for (uint8_t cy = 0; cy < heightBytes; ++cy)
     {
-        for (uint8_t cy = 0; cy < heightBytes; ++cy)
+        int posn;
+        if (heightBytes > 1 && cy == (heightBytes - 1))
+            posn = font_height - 8;
+        else
+            posn = cy * 8;
+        for (uint8_t cx = 0; cx < char_width; ++cx)
         {
-            uint8_t value = pgm_read_byte(image + cy * char_width + cx);
-            int posn;
-            if (heightBytes > 1 && cy == (heightBytes - 1))
-                posn = font_height - 8;
-            else
-                posn = cy * 8;
+            uint8_t value = reader.readByte();
             for (uint8_t bit = 0; bit < 8; ++bit)
             {
                 if ((posn + bit) >= (cy * 8) && (posn + bit) <= font_height)
@@ -404,24 +1083,194 @@ int Bitmap::drawChar(int x, int y, char ch)
             }
         }
     }
-    return char_width;
+}
+
+template <typename Reader>
+void Bitmap::drawScaledGlyphImage(Reader &reader, int x, int y, const Glyph &glyph)
+{
+    // Decode the glyph a row at a time in row-major form, whatever its
+    // encoding, and stretch each row as it is written.
+    uint8_t scale = textScale;
+    uint8_t font_height = glyph.height;
+    uint8_t char_width = glyph.width;
+    uint8_t stride = (char_width + 7) >> 3;
+    if (glyph.encoding == FONT_ENCODING_ROW_MAJOR)
+    {
+        uint8_t row[32];
+        for (uint8_t cy = 0; cy < font_height; ++cy)
+        {
+            int posn = y + cy * scale;
+            if (posn >= scr_height)
+                break;
+            reader.readBytes(row, stride);
+            writeScaledRow(x, posn, row, char_width, textColor, scale);
+        }
+        return;
+    }
+    if (glyph.encoding == FONT_ENCODING_PACKED)
+    {
+        uint8_t row[32];
+        BitReader<Reader> bits(reader);
+        PackedBox box;
+        readPackedBox(bits, font_height, char_width, box);
+        for (uint8_t cy = 0; cy < font_height; ++cy)
+        {
+            int posn = y + cy * scale;
+            if (posn >= scr_height)
+                break;
+            memset(row, 0, stride);
+            if ((uint8_t)(cy - box.top) < box.height)
+                unpackBits(bits, box.width, row, box.left);
+            writeScaledRow(x, posn, row, char_width, textColor, scale);
+        }
+        return;
+    }
+
+    // Column-major glyphs are turned into rows a band of 8 at a time.
+    uint8_t band[8 * 32];
+    uint8_t heightBytes = (font_height + 7) >> 3;
+    for (uint8_t cy = 0; cy < heightBytes; ++cy)
+    {
+        // The last band is aligned with the bottom of the glyph, so skip
+        // the rows that it shares with the band above.
+        uint8_t first = cy * 8;
+        uint8_t shift = 0;
+        if (heightBytes > 1 && cy == (heightBytes - 1))
+            shift = first - (font_height - 8);
+        memset(band, 0, 8 * stride);
+        for (uint8_t cx = 0; cx < char_width; ++cx)
+        {
+            uint8_t value = reader.readByte() >> shift;
+            uint8_t mask = 0x80 >> (cx & 0x07);
+            for (uint8_t *ptr = band + (cx >> 3); value; ptr += stride, value >>= 1)
+            {
+                if (value & 0x01)
+                    *ptr |= mask;
+            }
+        }
+        for (uint8_t row = 0; row < 8 && (first + row) < font_height; ++row)
+        {
+            int posn = y + (first + row) * scale;
+            if (posn >= scr_height)
+                return;
+            writeScaledRow(x, posn, band + row * stride, char_width, textColor, scale);
+        }
+    }
+}
+
+void Bitmap::rasterizeGlyph(const Glyph &glyph, uint8_t *rows) const
+{
+    // Convert a glyph into row-major form.
+    Glyph loaded = glyph;
+    if (!loadGlyphImage(loaded))
+    {
+        memset(rows, 0, ((glyph.width + 7) >> 3) * glyph.height);
+        return;
+    }
+    if (loaded.file)
+    {
+        FileFontReader reader(loaded.file, loaded.image);
+        rasterizeGlyphImage(reader, loaded, rows);
+    }
+    else
+    {
+        FlashReader reader(loaded.font + loaded.image);
+        rasterizeGlyphImage(reader, loaded, rows);
+    }
+}
+
+template <typename Reader>
+void Bitmap::rasterizeGlyphImage(Reader &reader, const Glyph &glyph, uint8_t *rows)
+{
+    uint8_t font_height = glyph.height;
+    uint8_t char_width = glyph.width;
+    uint8_t stride = (char_width + 7) >> 3;
+    if (glyph.encoding == FONT_ENCODING_ROW_MAJOR)
+    {
+        reader.readBytes(rows, stride * font_height);
+        return;
+    }
+    memset(rows, 0, stride * font_height);
+    if (glyph.encoding == FONT_ENCODING_PACKED)
+    {
+        BitReader<Reader> bits(reader);
+        PackedBox box;
+        readPackedBox(bits, font_height, char_width, box);
+        for (uint8_t cy = 0; cy < box.height; ++cy)
+            unpackBits(bits, box.width, rows + (box.top + cy) * stride, box.left);
+        return;
+    }
+    uint8_t heightBytes = (font_height + 7) >> 3;
+    for (uint8_t cy = 0; cy < heightBytes; ++cy)
+    {
+        for (uint8_t cx = 0; cx < char_width; ++cx)
+        {
+            uint8_t *column = rows + (cx >> 3);
+            uint8_t mask = 0x80 >> (cx & 0x07);
+            uint8_t value = reader.readByte();
+            uint8_t posn;
+            if (heightBytes > 1 && cy == (heightBytes - 1))
+            {
+                // The last byte is aligned with the bottom of the glyph.
+                posn = font_height - 8;
+                value >>= cy * 8 - posn;
+                posn = cy * 8;
+            }
+            else
+            {
+                posn = cy * 8;
+            }
+            for (; value && posn < font_height; ++posn, value >>= 1)
+            {
+                if (value & 0x01)
+                    column[posn * stride] |= mask;
+            }
+        }
+    }
+}
+
+bool Bitmap::drawCachedGlyph(int x, int y, const Glyph &glyph)
+{
+    uint8_t font_height = glyph.height;
+    uint8_t stride = (glyph.width + 7) >> 3;
+    const uint8_t *rows = _glyphCache->find(glyph.font, glyph.index);
+    if (!rows)
+    {
+        uint8_t *slot = _glyphCache->insert(glyph.font, glyph.index, glyph.width, font_height);
+        if (!slot)
+            return false; // Glyph is too big for the cache.
+        rasterizeGlyph(glyph, slot);
+        rows = slot;
+    }
+    for (uint8_t cy = 0; cy < font_height; ++cy)
+    {
+        int posn = y + cy * textScale;
+        if (posn >= scr_height)
+            break;
+        if (textScale > 1)
+            writeScaledRow(x, posn, rows, glyph.width, textColor, textScale);
+        else if (posn >= 0)
+            writeRow(x, posn, rows, glyph.width, textColor);
+        rows += stride;
+    }
+    return true;
 }
 
 int Bitmap::getCharWidth(char letter) const
 {
-    uint8_t index = (uint8_t)letter;
-    if (!_font)
+    return getCodePointWidth((uint8_t)letter);
+}
+
+int Bitmap::getCodePointWidth(uint32_t code) const
+{
+    if (!_fontInfo.font)
         return 0;
-    uint8_t first_char = Font_getFirstChar(_font);
-    uint8_t char_count = Font_getCharCount(_font);
-    if (index == ' ')
-        index = 'n'; // In case the font does not contain space.
-    if (index < first_char || index >= (first_char + char_count))
+    if (code == ' ')
+        return getSpaceWidth() * textScale;
+    Glyph glyph;
+    if (!resolveGlyph(code, glyph))
         return 0;
-    if (Font_IsFixed(_font))
-        return Font_getWidth(_font);
-    else
-        return pgm_read_byte(_font + 6 + (index - first_char));
+    return glyph.width * textScale;
 }
 
 int Bitmap::getTextWidth(const char *str, int len) const
@@ -429,35 +1278,57 @@ int Bitmap::getTextWidth(const char *str, int len) const
     int text_width = 0;
     if (len < 0)
         len = strlen(str);
-    while (len-- > 0)
+    StringReader reader(str);
+    while (len > 0)
     {
-        text_width += getCharWidth(*str++);
+        text_width += getCodePointWidth(nextCodePoint(reader, len));
         if (len > 0)
-            ++text_width;
+            text_width += textScale;
     }
     return text_width;
 }
 
 int Bitmap::getTextWidth(const String &str, int start, int len) const
 {
-    int text_width = 0;
     if (len < 0)
         len = str.length() - start;
-    while (len-- > 0)
+    return getTextWidth(str.c_str() + start, len);
+}
+
+int Bitmap::getTextWidth_P(PGM_P str, int len) const
+{
+    int text_width = 0;
+    int count = 0;
+    FlashReader reader(str);
+    while (len != 0)
     {
-        text_width += getCharWidth(str[start++]);
-        if (len > 0)
-            ++text_width;
+        uint32_t code = nextCodePoint(reader, len);
+        if (!code && len < 0)
+            break;
+        text_width += getCodePointWidth(code);
+        ++count;
     }
+    if (count > 1)
+        text_width += (count - 1) * textScale; // Gap between characters.
     return text_width;
 }
 
+int Bitmap::getTextWidth_P(const __FlashStringHelper *str, int len) const
+{
+    return getTextWidth_P((PGM_P)str, len);
+}
+
 int Bitmap::getTextHeight() const
 {
-    if (_font)
-        return Font_getHeight(_font);
-    else
-        return 0;
+    return _fontInfo.height * textScale;
+}
+
+int Bitmap::getTextBaseline() const
+{
+    // FontCreator fonts do not record a baseline, so use the bottom row.
+    if (_fontInfo.baseline)
+        return _fontInfo.baseline * textScale;
+    return getTextHeight();
 }
 
 void Bitmap::copy(int x, int y, int width, int height, Bitmap *dest, int destX, int destY)
@@ -468,6 +1339,19 @@ void Bitmap::copy(int x, int y, int width, int height, Bitmap *dest, int destX,
         // that will prevent problems with overlap.
         blit(x, y, x + width - 1, y + height - 1, destX, destY);
     }
+    else if (x >= 0 && y >= 0 && (x + width) <= scr_width && (y + height) <= scr_height)
+    {
+        // Copying to a different bitmap from within this one, so copy
+        // whole rows.  Writing in Black keeps the frame buffer's polarity.
+        const uint8_t *line = frame_buffer + y * scr_stride + (x >> 3);
+        while (height > 0)
+        {
+            dest->writeRow(destX, destY, line, width, Black, x & 0x07);
+            line += scr_stride;
+            ++destY;
+            --height;
+        }
+    }
     else
     {
         // Copying to a different bitmap.
@@ -495,41 +1379,27 @@ void Bitmap::fill(int x, int y, int width, int height, uint8_t color)
 
 void Bitmap::fill(int x, int y, int width, int height, PGM_VOID_P pattern, uint8_t color)
 {
-    uint8_t bitmap_w = pgm_read_byte(pattern);
+    FlashReader reader(pattern);
+    uint8_t bitmap_w = reader.readByte();
     uint8_t bitmap_s = (bitmap_w + 7) >> 3;
-    uint8_t bitmap_h = pgm_read_byte(pattern + 1);
+    uint8_t bitmap_h = reader.readByte();
     if (!bitmap_w || !bitmap_h)
         return;
-    uint8_t invColor = !color;
+    const uint8_t *start = reader.position();
+    uint8_t line[32];
     for (int tempy = 0; tempy < height; ++tempy)
     {
-        const uint8_t *startLine = ((const uint8_t *)pattern) + 2 + (tempy % bitmap_h) * bitmap_s;
-        const uint8_t *line = startLine;
-        uint8_t mask = 0x80;
-        uint8_t value = pgm_read_byte(line++);
-        int bit = 0;
-        for (int tempx = 0; tempx < width; ++tempx)
+        // Copy the row of the pattern out of flash once and repeat it
+        // across the area.
+        if ((tempy % bitmap_h) == 0)
+            reader.seek(start);
+        reader.readBytes(line, bitmap_s);
+        for (int tempx = 0; tempx < width; tempx += bitmap_w)
         {
-            if (value & mask)
-                setPixel(x + tempx, y + tempy, color);
-            else
-                setPixel(x + tempx, y + tempy, invColor);
-            if (++bit >= bitmap_w)
-            {
-                mask = 0x80;
-                line = startLine;
-                value = pgm_read_byte(line++);
-                bit = 0;
-            }
-            else
-            {
-                mask >>= 1;
-                if (!mask)
-                {
-                    mask = 0x80;
-                    value = pgm_read_byte(line++);
-                }
-            }
+            int count = width - tempx;
+            if (count > bitmap_w)
+                count = bitmap_w;
+            writeRow(x + tempx, y + tempy, line, count, color);
         }
     }
 }
@@ -641,6 +1511,124 @@ void Bitmap::blit(int x1, int y1, int x2, int y2, int x3, int y3)
     }
 }
 
+void Bitmap::writeRow(int x, int y, const uint8_t *bits, int width, uint8_t color, int offset)
+{
+    // Write "width" pixels from "bits" (MSB first, 1 = color) to row "y"
+    // starting at column "x".  Pixels that are 0 are set to !color.  The
+    // first pixel is "offset" bits into "bits".
+    if (((unsigned int)y) >= ((unsigned int)scr_height))
+        return;
+    int skip = offset;
+    if (x < 0)
+    {
+        skip -= x;
+        width += x;
+        x = 0;
+    }
+    if ((x + width) > scr_width)
+        width = scr_width - x;
+    if (width <= 0)
+        return;
+    uint8_t *ptr = frame_buffer + y * scr_stride + (x >> 3);
+    uint8_t shift = x & 0x07;
+    uint8_t polarity = color ? 0xFF : 0x00; // Frame buffer uses 1 = off.
+    while (width > 0)
+    {
+        // Fetch the next "count" source bits, aligned to the top of "value".
+        uint8_t count = 8 - shift;
+        if (count > width)
+            count = width;
+        const uint8_t *src = bits + (skip >> 3);
+        uint8_t bit = skip & 0x07;
+        uint8_t value = src[0] << bit;
+        if ((bit + count) > 8)
+            value |= src[1] >> (8 - bit);
+        uint8_t mask = ((uint8_t)(0xFF << (8 - count))) >> shift;
+        *ptr = (*ptr & ~mask) | (((uint8_t)(value ^ polarity) >> shift) & mask);
+        ++ptr;
+        skip += count;
+        width -= count;
+        shift = 0;
+    }
+}
+
+// Each nibble stretched to 2, 3 and 4 times as many bits, so that a byte
+// of pixels becomes 16, 24 or 32 bits with two lookups.
+static const uint8_t scale2Bits[16] = {
+    0x00, 0x03, 0x0C, 0x0F, 0x30, 0x33, 0x3C, 0x3F,
+    0xC0, 0xC3, 0xCC, 0xCF, 0xF0, 0xF3, 0xFC, 0xFF
+};
+static const uint16_t scale3Bits[16] = {
+    0x0000, 0x0007, 0x0038, 0x003F, 0x01C0, 0x01C7, 0x01F8, 0x01FF,
+    0x0E00, 0x0E07, 0x0E38, 0x0E3F, 0x0FC0, 0x0FC7, 0x0FF8, 0x0FFF
+};
+static const uint16_t scale4Bits[16] = {
+    0x0000, 0x000F, 0x00F0, 0x00FF, 0x0F00, 0x0F0F, 0x0FF0, 0x0FFF,
+    0xF000, 0xF00F, 0xF0F0, 0xF0FF, 0xFF00, 0xFF0F, 0xFFF0, 0xFFFF
+};
+
+// Stretches "count" bytes of pixels from "bits" by "scale" into "dest".
+static void scaleBits(const uint8_t *bits, int count, uint8_t scale, uint8_t *dest)
+{
+    switch (scale)
+    {
+    case 2:
+        while (count-- > 0)
+        {
+            uint8_t value = *bits++;
+            *dest++ = scale2Bits[value >> 4];
+            *dest++ = scale2Bits[value & 0x0F];
+        }
+        break;
+    case 3:
+        while (count-- > 0)
+        {
+            uint8_t value = *bits++;
+            uint32_t wide = (((uint32_t)scale3Bits[value >> 4]) << 12) | scale3Bits[value & 0x0F];
+            *dest++ = (uint8_t)(wide >> 16);
+            *dest++ = (uint8_t)(wide >> 8);
+            *dest++ = (uint8_t)wide;
+        }
+        break;
+    default:
+        while (count-- > 0)
+        {
+            uint8_t value = *bits++;
+            uint16_t high = scale4Bits[value >> 4];
+            uint16_t low = scale4Bits[value & 0x0F];
+            *dest++ = (uint8_t)(high >> 8);
+            *dest++ = (uint8_t)high;
+            *dest++ = (uint8_t)(low >> 8);
+            *dest++ = (uint8_t)low;
+        }
+        break;
+    }
+}
+
+void Bitmap::writeScaledRow(int x, int y, const uint8_t *bits, int width, uint8_t color, uint8_t scale)
+{
+    // Write "width" pixels from "bits" as in writeRow(), but "scale" times
+    // as wide and as "scale" rows starting at "y".  Each row is stretched
+    // once and then written to all of the rows.
+    uint8_t row[BITMAP_MAX_SCALE * 32];
+    if (y >= scr_height || (y + scale) <= 0)
+        return;
+    while (width > 0 && x < scr_width)
+    {
+        // Stretch up to 256 pixels at a time.
+        int count = (width > 256) ? 256 : width;
+        if ((x + count * scale) > 0)
+        {
+            scaleBits(bits, (count + 7) >> 3, scale, row);
+            for (uint8_t temp = 0; temp < scale; ++temp)
+                writeRow(x, y + temp, row, count * scale, color);
+        }
+        bits += 32;
+        x += count * scale;
+        width -= count;
+    }
+}
+
 void Bitmap::drawCirclePoints(int centerX, int centerY, int radius, int x, int y, uint8_t borderColor, uint8_t fillColor)
 {
     if (x != y)
@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <inttypes.h>
 #include <pgmspace.h>
+#include <Print.h>
 
 // Six byte header at beginning of FontCreator font structure, stored in PROGMEM
 struct FontHeader
@@ -15,6 +16,97 @@ struct FontHeader
     uint8_t charCount;
 };
 
+// Eight byte header at beginning of fonts generated by tools/fontconv.py,
+// stored in PROGMEM.  The last four fields line up with FontHeader.  The
+// header is followed by charCount + 1 little-endian glyph offsets from the
+// start of the font, charCount glyph widths and then the glyph data.
+struct ExtFontHeader
+{
+    uint8_t marker;
+    uint8_t encoding;
+    uint8_t width;
+    uint8_t height;
+    uint8_t firstChar;
+    uint8_t charCount;
+    uint8_t flags;
+    uint8_t baseline; // Rows from the top to the baseline, or 0 if unknown.
+};
+
+// Value of ExtFontHeader::marker.  FontCreator fonts never start with it.
+#define FONT_EXT_MARKER 0xFF
+
+// Glyph encodings in ExtFontHeader::encoding.
+#define FONT_ENCODING_COLUMN_MAJOR 0 // Columns of bytes, as in FontCreator fonts.
+#define FONT_ENCODING_ROW_MAJOR 1 // Rows of 1bpp pixels, MSB first, like Bitmap.
+#define FONT_ENCODING_PACKED 2    // Bounding box, then its pixels as a bit stream.
+
+// Each FONT_ENCODING_PACKED glyph is a stream of bits, MSB first.  It
+// starts with the top row and height of the box around the glyph's pixels,
+// each as many bits as the font height needs, then the left column and
+// width of the box, each as many bits as the glyph width needs.  The rows
+// of the box follow with no padding between them, 1 = pixel on.  Pixels
+// outside the box are off.
+
+// Flags in ExtFontHeader::flags.
+#define FONT_FLAG_FIXED_WIDTH 0x01
+#define FONT_FLAG_RANGES 0x02 // Glyphs cover several ranges of code points.
+#define FONT_FLAG_MAP 0x04    // Codes map to glyphs through a byte table.
+
+// Range of code points in a font with FONT_FLAG_RANGES.  The header of
+// such fonts is followed by a uint16_t glyph count, a uint16_t range count
+// and the ranges sorted by first code point.  firstChar and charCount in
+// the header are unused.  All fields are little-endian.
+struct FontRange
+{
+    uint32_t firstCode;
+    uint16_t count;
+    uint16_t firstGlyph;
+};
+
+// Fonts with FONT_FLAG_MAP hold only some of the codes from firstChar to
+// firstChar + charCount - 1, such as the characters used by one sketch.
+// The header is followed by a uint8_t glyph count and one byte for each
+// of the charCount codes giving its glyph, or FONT_MAP_NONE if missing.
+#define FONT_MAP_NONE 0xFF
+
+class FileFont;
+
+// A font's header and tables decoded into RAM by Bitmap::setFont(), so
+// that drawing text does not have to parse the font again.  Tables are
+// held as offsets from the start of the font, whether it is in PROGMEM
+// or read from a FileFont, and are 0 if the font does not have them.
+struct FontInfo
+{
+    const uint8_t *font;   // Start of the font or the FileFont, or 0 if none.
+    FileFont *file;        // Font the tables are read from, or 0 for PROGMEM.
+    uint32_t data;         // Glyph data of FontCreator fonts.
+    uint32_t widths;       // Width of each glyph, or 0 if all are "width".
+    uint32_t offsets;      // Little-endian glyph offsets of extended fonts.
+    const uint16_t *index; // Glyph offsets of variable-width FontCreator fonts.
+    uint32_t ranges;       // FontRange table, or 0 for one run from firstChar.
+    uint32_t map;          // Glyph of each code from firstChar, or 0.
+    uint16_t glyphCount;
+    uint16_t rangeCount;
+    uint8_t width;
+    uint8_t height;
+    uint8_t firstChar;
+    uint8_t mapCount; // Number of codes in "map".
+    uint8_t encoding; // FONT_ENCODING_COLUMN_MAJOR for FontCreator fonts.
+    uint8_t flags;    // FONT_FLAG_* for all fonts.
+    uint8_t baseline;
+    uint8_t spaceWidth; // Width drawn for ' ', allowing for fallback fonts.
+};
+
+// Number of fonts that can be searched for glyphs missing from the font.
+#define BITMAP_MAX_FALLBACK_FONTS 3
+
+// Number of code points to remember the font and glyph of when searching
+// several ranges or fonts.  Must be a power of two.
+#define BITMAP_RESOLVE_CACHE_SIZE 32
+
+// Largest factor that text and bitmaps can be scaled up by.
+#define BITMAP_MAX_SCALE 4
+
 enum Color
 {
     Black = 0,
@@ -23,9 +115,10 @@ enum Color
 };
 
 class DMDESP;
+class GlyphCache;
 class String;
 
-class Bitmap
+class Bitmap : public Print
 {
 public:
     Bitmap(int width, int height);
@@ -55,27 +148,59 @@ public:
     void drawCircle(int centerX, int centerY, int radius, uint8_t borderColor = White, uint8_t fillColor = NoFill);
     void drawFilledCircle(int centerX, int centerY, int radius, uint8_t color = White);
 
-    void drawBitmap(int x, int y, const Bitmap &bitmap, uint8_t color = White);
-    void drawBitmap(int x, int y, PGM_VOID_P bitmap, uint8_t color = White);
+    void drawBitmap(int x, int y, const Bitmap &bitmap, uint8_t color = White, uint8_t scale = 1);
+    void drawBitmap(int x, int y, PGM_VOID_P bitmap, uint8_t color = White, uint8_t scale = 1);
     void drawInvertedBitmap(int x, int y, const Bitmap &bitmap);
     void drawInvertedBitmap(int x, int y, PGM_VOID_P bitmap);
 
-    uint8_t *getFont() const { return _font; }
-    void setFont(const uint8_t *font);
+    uint8_t *getFont() const { return (uint8_t *)_fontInfo.font; }
+    const FontInfo &getFontInfo() const { return _fontInfo; }
+    bool setFont(const uint8_t *font);
+    bool setFont(FileFont &font);
+    FileFont *getFileFont() const { return _fontInfo.file; }
+    bool addFallbackFont(const uint8_t *font);
+    bool addFallbackFont(FileFont &font);
+    void clearFallbackFonts();
+    uint8_t getFallbackFontCount() const { return _numFallbackFonts; }
+    const FontInfo &getFallbackFontInfo(uint8_t index) const { return _fallbackFonts[index]; }
+
+    GlyphCache *getGlyphCache() const { return _glyphCache; }
+    void setGlyphCache(GlyphCache *cache) { _glyphCache = cache; }
 
     uint8_t getTextColor() const { return textColor; }
     void setTextColor(uint8_t color) { textColor = color; }
 
+    // Text is drawn "scale" times wider and higher, gaps included.
+    uint8_t getTextScale() const { return textScale; }
+    void setTextScale(uint8_t scale);
+
     int drawChar(int x, int y, char ch);
+    int drawCodePoint(int x, int y, uint32_t code);
     void drawString(int x, int y, const char *str, int len = -1);
     void drawString(int x, int y, const String &str, int start = 0, int len = -1);
+    void drawText(int x, int y, const char *str, int len);
     void drawString_P(int x, int y, PGM_P str, int len = -1);
     void drawString_P(int x, int y, const __FlashStringHelper *str, int len = -1);
 
     int getCharWidth(char ch) const;
+    int getCodePointWidth(uint32_t code) const;
     int getTextWidth(const char *str, int len = -1) const;
     int getTextWidth(const String &str, int start = 0, int len = -1) const;
+    int getTextWidth_P(PGM_P str, int len = -1) const;
+    int getTextWidth_P(const __FlashStringHelper *str, int len = -1) const;
     int getTextHeight() const;
+    int getTextBaseline() const;
+
+    static uint32_t decodeUtf8(const char *&str, int &len);
+
+    int getCursorX() const { return cursorX; }
+    int getCursorY() const { return cursorY; }
+    void setCursor(int x, int y);
+    bool getTextWrap() const { return textWrap; }
+    void setTextWrap(bool wrap) { textWrap = wrap; }
+
+    size_t write(uint8_t ch);
+    using Print::write;
 
     void copy(int x, int y, int width, int height, Bitmap *dest, int destX, int destY);
     void fill(int x, int y, int width, int height, uint8_t color);
@@ -95,12 +220,66 @@ private:
     int scr_height;
     int scr_stride;
     uint8_t *frame_buffer;
-    uint8_t *_font;
+    FontInfo _fontInfo;
+    GlyphCache *_glyphCache;
     uint8_t textColor;
+    uint8_t textScale;
+    int16_t cursorX;
+    int16_t cursorY;
+    bool textWrap;
+    uint8_t utf8Count;
+    uint8_t utf8Need;
+    char utf8Buf[4];
+
+    struct Glyph
+    {
+        const uint8_t *font;
+        uint32_t image; // Offset of the glyph from the start of the font.
+        FileFont *file;
+        uint16_t index;
+        uint8_t width;
+        uint8_t height;
+        uint8_t encoding;
+        bool hasImage; // False if found in the glyph cache without "image".
+    };
+
+    struct ResolvedGlyph
+    {
+        uint32_t code;
+        Glyph glyph;
+    };
+
+    ResolvedGlyph *_resolveCache;
+    FontInfo _fallbackFonts[BITMAP_MAX_FALLBACK_FONTS];
+    uint8_t _numFallbackFonts;
 
     friend class DMDESP;
+    friend class TextRun;
+    friend class TextTicker;
 
     void blit(int x1, int y1, int x2, int y2, int x3, int y3);
+    void writeRow(int x, int y, const uint8_t *bits, int width, uint8_t color, int offset = 0);
+    void writeScaledRow(int x, int y, const uint8_t *bits, int width, uint8_t color, uint8_t scale);
+    void allocResolveCache();
+    void clearResolveCache();
+    bool loadFont(const uint8_t *font, FileFont *file);
+    bool loadFallbackFont(const uint8_t *font, FileFont *file);
+    bool resolveGlyph(uint32_t code, Glyph &glyph) const;
+    void findGlyph(const FontInfo &info, uint16_t index, Glyph &glyph) const;
+    static void loadGlyph(const FontInfo &info, uint16_t index, Glyph &glyph);
+    bool loadGlyphImage(Glyph &glyph) const;
+    void updateSpaceWidth();
+    int getSpaceWidth() const { return _fontInfo.spaceWidth; }
+    int drawGlyph(int x, int y, const Glyph &glyph);
+    template <typename Reader>
+    void drawGlyphImage(Reader &reader, int x, int y, const Glyph &glyph);
+    template <typename Reader>
+    void drawScaledGlyphImage(Reader &reader, int x, int y, const Glyph &glyph);
+    void rasterizeGlyph(const Glyph &glyph, uint8_t *rows) const;
+    template <typename Reader>
+    static void rasterizeGlyphImage(Reader &reader, const Glyph &glyph, uint8_t *rows);
+    bool drawCachedGlyph(int x, int y, const Glyph &glyph);
+    void printCodePoint(uint32_t code);
     void drawCirclePoints(int centerX, int centerY, int radius, int x, int y, uint8_t borderColor, uint8_t fillColor);
 };
 
@@ -5,11 +5,28 @@
 #include "Bitmap.h"
 #include "DMDESP.h"
 
-DMDESP::DMDESP(int widthPanels, int heightPanels)
-    : Bitmap(widthPanels * DMDESP_NUM_COLUMNS, heightPanels * DMDESP_NUM_ROWS), useDoubleBuffer(false), phase(0), fb0(0), fb1(0), displayfb(0), lastRefresh(millis())
+DMDESP::DMDESP(int widthPanels, int heightPanels, uint8_t scan)
+    : Bitmap(widthPanels * DMDESP_NUM_COLUMNS, heightPanels * DMDESP_NUM_ROWS), useDoubleBuffer(false), phase(0), scanPhases(scan), panelsWide(widthPanels), panelsHigh(heightPanels), fb0(0), fb1(0), displayfb(0), lastRefresh(millis()), panelLayout(0), scanRuns(0), numScanRuns(0), rowOrder(0), rowSource(0), rowContext(0), rowSlots(0), numRowSlots(0)
 {
-    // Both rendering and display are to fb0 initially.
+    init();
+}
+
+DMDESP::DMDESP(int widthPanels, int heightPanels, DMDRowSource source, void *context, uint8_t scan)
+    : Bitmap(0, 0), useDoubleBuffer(false), phase(0), scanPhases(scan), panelsWide(widthPanels), panelsHigh(heightPanels), fb0(0), fb1(0), displayfb(0), lastRefresh(millis()), panelLayout(0), scanRuns(0), numScanRuns(0), rowOrder(0), rowSource(source), rowContext(context), rowSlots(0), numRowSlots(0)
+{
+    init();
+}
+
+void DMDESP::init()
+{
+    // Both rendering and display are to fb0 initially.  In row mode the
+    // row buffer is displayed instead once start() has allocated it.
     fb0 = displayfb = frame_buffer;
+    if (rowSource)
+        displayfb = 0;
+
+    if (scanPhases != DMD_SCAN_2 && scanPhases != DMD_SCAN_8 && scanPhases != DMD_SCAN_16)
+        scanPhases = DMD_SCAN_4;
 
     // Initialize SPI to MSB-first, mode 0, clock divider = 2.
     pinMode(DMD_PIN_SPI_SCK, OUTPUT);
@@ -22,6 +39,16 @@ DMDESP::DMDESP(int widthPanels, int heightPanels)
     pinMode(DMD_PIN_B, OUTPUT);
     pinMode(DMD_PIN_LATCH, OUTPUT);
     pinMode(DMD_PIN_OUTPUT_ENABLE, OUTPUT);
+    if (scanPhases >= DMD_SCAN_8)
+    {
+        pinMode(DMD_PIN_C, OUTPUT);
+        GPOC = (1 << DMD_PIN_C); // Set to LOW
+    }
+    if (scanPhases >= DMD_SCAN_16)
+    {
+        pinMode(DMD_PIN_D, OUTPUT);
+        GPOC = (1 << DMD_PIN_D); // Set to LOW
+    }
 
     GPOC = (1 << DMD_PIN_A);             // Set to LOW
     GPOC = (1 << DMD_PIN_B);             // Set to LOW
@@ -36,11 +63,19 @@ DMDESP::~DMDESP()
         free(fb0);
     if (fb1)
         free(fb1);
+    if (scanRuns)
+        free(scanRuns);
+    if (rowSource && displayfb)
+        free(displayfb);
+    if (rowSlots)
+        free(rowSlots);
     frame_buffer = 0; // Don't free the buffer again in the base class.
 }
 
 void DMDESP::setDoubleBuffer(bool state)
 {
+    if (rowSource)
+        return; // Nothing to double-buffer in row mode.
     if (state != useDoubleBuffer)
     {
         useDoubleBuffer = state;
@@ -143,7 +178,9 @@ void DMDESP::loop()
 }
 
 // Flip the bits in a byte.  Table generated by genflip.c
-static const uint8_t flipBits[256] PROGMEM = {
+// The table is looked up at random for every byte of a flipped row, which
+// a streaming flash reader cannot help with, so it is kept in RAM.
+static const uint8_t flipBits[256] = {
     0x00, 0x80, 0x40, 0xC0, 0x20, 0xA0, 0x60, 0xE0, 0x10, 0x90, 0x50, 0xD0,
     0x30, 0xB0, 0x70, 0xF0, 0x08, 0x88, 0x48, 0xC8, 0x28, 0xA8, 0x68, 0xE8,
     0x18, 0x98, 0x58, 0xD8, 0x38, 0xB8, 0x78, 0xF8, 0x04, 0x84, 0x44, 0xC4,
@@ -167,48 +204,311 @@ static const uint8_t flipBits[256] PROGMEM = {
     0x0F, 0x8F, 0x4F, 0xCF, 0x2F, 0xAF, 0x6F, 0xEF, 0x1F, 0x9F, 0x5F, 0xDF,
     0x3F, 0xBF, 0x7F, 0xFF};
 
-void DMDESP::refresh()
+bool DMDESP::setPanelLayout(const DMDPanel *panels, uint8_t count)
+{
+    // Sets the panel in each position of the chain, or the default layout
+    // if "panels" is 0.  The table is read by start(), so it must last
+    // until then.  Returns false if it does not fit the display, in which
+    // case the previous layout is kept.
+    if (panels)
+    {
+        if (count != panelsWide * panelsHigh)
+            return false;
+        for (uint8_t index = 0; index < count; ++index)
+        {
+            if (panels[index].x >= panelsWide || panels[index].y >= panelsHigh)
+                return false;
+        }
+    }
+    panelLayout = panels;
+    if (scanRuns)
+        return compileLayout(); // Already started.
+    return true;
+}
+
+bool DMDESP::setRowOrder(const uint8_t *rows)
+{
+    // Sets the order that rows are lit and sent in, or the default order
+    // if "rows" is 0.  The table is read by start(), so it must last until
+    // then.  Returns false if it does not hold each row of a panel once.
+    if (rows)
+    {
+        uint16_t seen = 0;
+        for (uint8_t index = 0; index < DMDESP_NUM_ROWS; ++index)
+        {
+            if (rows[index] >= DMDESP_NUM_ROWS || (seen & (1 << rows[index])))
+                return false;
+            seen |= 1 << rows[index];
+        }
+    }
+    rowOrder = rows;
+    if (scanRuns)
+        return compileLayout(); // Already started.
+    return true;
+}
+
+bool DMDESP::compileLayout()
 {
-    // Transfer the data for the next group of interleaved rows.
-    int stride4 = scr_stride * 4;
-    volatile uint8_t *data0;
-    volatile uint8_t *data1;
-    volatile uint8_t *data2;
-    volatile uint8_t *data3;
-    bool flipRow = ((scr_height & 0x10) == 0);
-    for (byte y = 0; y < scr_height; y += DMDESP_NUM_ROWS)
+    // Work out where in the frame buffer the bytes for each panel come
+    // from, in the order that they are sent.  The first bytes sent are
+    // shifted all the way along the chain to the last panel.
+    int widthPanels = panelsWide;
+    int heightPanels = panelsHigh;
+    int count = widthPanels * heightPanels;
+    int stride = widthPanels * (DMDESP_NUM_COLUMNS / 8);
+    uint8_t rows = DMDESP_NUM_ROWS / scanPhases;
+    ScanRun *runs = (ScanRun *)malloc(sizeof(ScanRun) * (count ? count : 1));
+    uint8_t *slots = 0;
+    uint8_t numSlots = 0;
+    if (rowSource)
+        slots = (uint8_t *)malloc(heightPanels * 2 + 1);
+    if (!runs || (rowSource && !slots))
+    {
+        free(runs);
+        free(slots);
+        return false;
+    }
+    uint8_t numRuns = 0;
+    for (int index = count - 1; index >= 0; --index)
     {
-        if (!flipRow)
+        DMDPanel panel;
+        if (panelLayout)
         {
-            // The panels in this row are the right way up.
-            data0 = displayfb + scr_stride * (y + phase);
-            data1 = data0 + stride4;
-            data2 = data1 + stride4;
-            data3 = data2 + stride4;
-            for (int x = scr_stride; x > 0; --x)
+            panel = panelLayout[index];
+        }
+        else
+        {
+            // By default the chain snakes up from the bottom right corner:
+            // left along the bottom row, then right along the row above
+            // with the panels upside down, and so on.
+            uint8_t row = index / widthPanels;
+            uint8_t col = index % widthPanels;
+            panel.y = heightPanels - 1 - row;
+            panel.x = (row & 1) ? col : widthPanels - 1 - col;
+            panel.flags = (row & 1) ? DMD_PANEL_ROTATE_180 : DMD_PANEL_NORMAL;
+        }
+
+        // Turning a panel around mirrors it and flips it upside down.
+        bool flipRows = (panel.flags & DMD_PANEL_ROTATE_180) != 0;
+        bool mirror = flipRows != ((panel.flags & DMD_PANEL_MIRROR) != 0);
+        ScanRun run;
+        if (rowSource)
+        {
+            // The row buffer only holds the current phase, with its rows
+            // in the order that they are sent.
+            uint8_t key = panel.y * 2 + (flipRows ? 1 : 0);
+            uint8_t slot = 0;
+            while (slot < numSlots && slots[slot] != key)
+                ++slot;
+            if (slot == numSlots)
+                slots[numSlots++] = key;
+            run.offset = slot * rows * stride;
+            run.phaseStep = 0;
+            run.rowStep = stride;
+        }
+        else if (flipRows)
+        {
+            run.offset = (panel.y * DMDESP_NUM_ROWS + DMDESP_NUM_ROWS - 1) * stride;
+            run.phaseStep = -stride;
+            run.rowStep = run.phaseStep * scanPhases;
+        }
+        else
+        {
+            run.offset = panel.y * DMDESP_NUM_ROWS * stride;
+            run.phaseStep = stride;
+            run.rowStep = run.phaseStep * scanPhases;
+        }
+        run.count = DMDESP_NUM_COLUMNS / 8;
+        run.offset += panel.x * run.count;
+        if (mirror)
+            run.offset += run.count - 1;
+        run.mirror = mirror;
+
+        // Add the panel to the previous run if it carries straight on.
+        if (numRuns)
+        {
+            ScanRun &last = runs[numRuns - 1];
+            int next = mirror ? last.offset - last.count : last.offset + last.count;
+            if (last.mirror == mirror && last.phaseStep == run.phaseStep && run.offset == next)
             {
-                SPI.write(*data3++);
-                SPI.write(*data2++);
-                SPI.write(*data1++);
-                SPI.write(*data0++);
+                last.count += run.count;
+                continue;
             }
-            flipRow = true;
         }
-        else
+        runs[numRuns++] = run;
+    }
+
+    uint8_t *phaseRows = 0;
+    if (rowSource)
+    {
+        phaseRows = (uint8_t *)malloc(numSlots * rows * stride + 1);
+        if (!phaseRows)
         {
-            data0 = displayfb + scr_stride * (y + DMDESP_NUM_ROWS - phase) - 1;
-            data1 = data0 - stride4;
-            data2 = data1 - stride4;
-            data3 = data2 - stride4;
-            for (int x = scr_stride; x > 0; --x)
+            free(runs);
+            free(slots);
+            return false;
+        }
+    }
+
+    int16_t offsets[2][DMDESP_NUM_ROWS];
+    if (rowOrder)
+    {
+        for (uint8_t index = 0; index < DMDESP_NUM_ROWS; ++index)
+        {
+            offsets[0][index] = rowOrder[index] * stride;
+            offsets[1][index] = -offsets[0][index];
+        }
+    }
+
+    ets_intr_lock(); // IRQ Disable
+    if (rowOrder)
+        memcpy(rowOffsets, offsets, sizeof(rowOffsets));
+    ScanRun *oldRuns = scanRuns;
+    uint8_t *oldSlots = rowSlots;
+    uint8_t *oldPhaseRows = rowSource ? displayfb : 0;
+    scanRuns = runs;
+    numScanRuns = numRuns;
+    if (rowSource)
+    {
+        rowSlots = slots;
+        numRowSlots = numSlots;
+        displayfb = phaseRows;
+    }
+    ets_intr_unlock(); // IRQ Enable
+    if (oldRuns)
+        free(oldRuns);
+    if (oldSlots)
+        free(oldSlots);
+    if (oldPhaseRows)
+        free(oldPhaseRows);
+    if (rowSource)
+        generateRows();
+    return true;
+}
+
+void DMDESP::generateRows()
+{
+    // Ask for the rows that the next refresh() sends, and invert them to
+    // the frame buffer's 1 = off.
+    int stride = panelsWide * (DMDESP_NUM_COLUMNS / 8);
+    uint8_t rows = DMDESP_NUM_ROWS / scanPhases;
+    uint8_t *row = displayfb;
+    for (uint8_t slot = 0; slot < numRowSlots; ++slot)
+    {
+        int top = (rowSlots[slot] >> 1) * DMDESP_NUM_ROWS;
+        bool flipRows = (rowSlots[slot] & 1) != 0;
+        for (uint8_t temp = 0; temp < rows; ++temp)
+        {
+            // The last row of a slot is sent first.
+            int y = rowOrder ? rowOrder[phase * rows + rows - 1 - temp] : phase + temp * scanPhases;
+            if (flipRows)
+                y = DMDESP_NUM_ROWS - 1 - y;
+            rowSource(top + y, row, panelsWide * DMDESP_NUM_COLUMNS, rowContext);
+            for (int x = 0; x < stride; ++x)
+                row[x] = ~row[x];
+            row += stride;
+        }
+    }
+}
+
+// Sends a byte from each of the "Rows" rows of a phase, the bottom row
+// first, unrolled at compile time for each scan ratio.
+template <uint8_t Rows>
+struct ScanRows
+{
+    static inline void write(volatile uint8_t *data, int rowStep)
+    {
+        ScanRows<Rows - 1>::write(data + rowStep, rowStep);
+        SPI.write(*data);
+    }
+
+    static inline void writeFlipped(volatile uint8_t *data, int rowStep)
+    {
+        ScanRows<Rows - 1>::writeFlipped(data + rowStep, rowStep);
+        SPI.transfer(flipBits[*data]);
+    }
+
+    // Sends the rows at "offsets" from "data", first to last.
+    static inline void writeOrdered(volatile uint8_t *data, const int16_t *offsets)
+    {
+        SPI.write(data[*offsets]);
+        ScanRows<Rows - 1>::writeOrdered(data, offsets + 1);
+    }
+
+    static inline void writeOrderedFlipped(volatile uint8_t *data, const int16_t *offsets)
+    {
+        SPI.transfer(flipBits[data[*offsets]]);
+        ScanRows<Rows - 1>::writeOrderedFlipped(data, offsets + 1);
+    }
+};
+
+template <>
+struct ScanRows<0>
+{
+    static inline void write(volatile uint8_t *, int) {}
+    static inline void writeFlipped(volatile uint8_t *, int) {}
+    static inline void writeOrdered(volatile uint8_t *, const int16_t *) {}
+    static inline void writeOrderedFlipped(volatile uint8_t *, const int16_t *) {}
+};
+
+template <uint8_t Rows>
+void DMDESP::sendPhase()
+{
+    // Transfer the data for the next group of interleaved rows, a run of
+    // panels at a time in the order worked out by compileLayout().
+    // Rows in a table order are looked up through rowOffsets, except in
+    // row mode where generateRows() has already put them in order.
+    bool ordered = rowOrder && !rowSource;
+    for (uint8_t index = 0; index < numScanRuns; ++index)
+    {
+        const ScanRun &run = scanRuns[index];
+        if (ordered)
+        {
+            volatile uint8_t *data = displayfb + run.offset;
+            const int16_t *offsets = rowOffsets[run.phaseStep < 0 ? 1 : 0] + phase * Rows;
+            if (!run.mirror)
+            {
+                for (int x = run.count; x > 0; --x)
+                    ScanRows<Rows>::writeOrdered(data++, offsets);
+            }
+            else
             {
-                SPI.transfer(pgm_read_byte(&(flipBits[*data3--])));
-                SPI.transfer(pgm_read_byte(&(flipBits[*data2--])));
-                SPI.transfer(pgm_read_byte(&(flipBits[*data1--])));
-                SPI.transfer(pgm_read_byte(&(flipBits[*data0--])));
+                for (int x = run.count; x > 0; --x)
+                    ScanRows<Rows>::writeOrderedFlipped(data--, offsets);
             }
-            flipRow = false;
+            continue;
         }
+        volatile uint8_t *data0 = displayfb + run.offset + run.phaseStep * phase;
+        int rowStep = run.rowStep;
+        if (!run.mirror)
+        {
+            for (int x = run.count; x > 0; --x)
+                ScanRows<Rows>::write(data0++, rowStep);
+        }
+        else
+        {
+            for (int x = run.count; x > 0; --x)
+                ScanRows<Rows>::writeFlipped(data0--, rowStep);
+        }
+    }
+}
+
+void DMDESP::refresh()
+{
+    switch (scanPhases)
+    {
+    case DMD_SCAN_2:
+        sendPhase<DMDESP_NUM_ROWS / DMD_SCAN_2>();
+        break;
+    case DMD_SCAN_8:
+        sendPhase<DMDESP_NUM_ROWS / DMD_SCAN_8>();
+        break;
+    case DMD_SCAN_16:
+        sendPhase<DMDESP_NUM_ROWS / DMD_SCAN_16>();
+        break;
+    default:
+        sendPhase<DMDESP_NUM_ROWS / DMD_SCAN_4>();
+        break;
     }
 
     pinMode(DMD_PIN_OUTPUT_ENABLE, INPUT);
@@ -216,12 +516,22 @@ void DMDESP::refresh()
     GPOS = (1 << DMD_PIN_LATCH); // Set to HIGH
     GPOC = (1 << DMD_PIN_LATCH); // Set to LOW
 
-    digitalWrite(DMD_PIN_A, bitRead(phase, LOW));
-    digitalWrite(DMD_PIN_B, bitRead(phase, HIGH));
+    digitalWrite(DMD_PIN_A, bitRead(phase, 0));
+    if (scanPhases >= DMD_SCAN_4)
+        digitalWrite(DMD_PIN_B, bitRead(phase, 1));
+    if (scanPhases >= DMD_SCAN_8)
+        digitalWrite(DMD_PIN_C, bitRead(phase, 2));
+    if (scanPhases >= DMD_SCAN_16)
+        digitalWrite(DMD_PIN_D, bitRead(phase, 3));
 
     pinMode(DMD_PIN_OUTPUT_ENABLE, OUTPUT);
     analogWrite(DMD_PIN_OUTPUT_ENABLE, brightness);
-    phase = (phase + 1) & 0x03;
+    phase = (phase + 1) & (scanPhases - 1);
+
+    // Make the next phase's rows now, while this one is lit, so that the
+    // next refresh() only has to send them.
+    if (rowSource && numScanRuns)
+        generateRows();
 }
 
 void DMDESP::start()
@@ -240,7 +550,8 @@ void DMDESP::start()
     uint8_t jsh = 0x11;
     while (jsh--)
     {
-        if (jsh == DMD_PIN_A || jsh == DMD_PIN_OUTPUT_ENABLE || jsh == DMD_PIN_B || jsh == DMD_PIN_LATCH)
+        if (jsh == DMD_PIN_A || jsh == DMD_PIN_OUTPUT_ENABLE || jsh == DMD_PIN_B || jsh == DMD_PIN_LATCH ||
+            (jsh == DMD_PIN_C && scanPhases >= DMD_SCAN_8) || (jsh == DMD_PIN_D && scanPhases >= DMD_SCAN_16))
         {
             GPOC = (1 << jsh); // Set to LOW
             pinMode(jsh, OUTPUT);
@@ -250,6 +561,7 @@ void DMDESP::start()
             continue;
         }
     }
+    compileLayout();
     tickOccured = false;
     dispinit();
 }
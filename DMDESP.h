@@ -8,6 +8,8 @@
 // Pins on the DMDESP connector board.
 #define DMD_PIN_A 16             //D0 // A PHASE_LSB
 #define DMD_PIN_B 12             //D6 // B PHASE_MSB
+#define DMD_PIN_C 5              //D1 // C, for 1/8 and 1/16 scan panels
+#define DMD_PIN_D 4              //D2 // D, for 1/16 scan panels
 #define DMD_PIN_LATCH 0          //D3 // SCLK
 #define DMD_PIN_OUTPUT_ENABLE 15 //D8 // nOE
 #define DMD_PIN_SPI_MOSI 13      //D7 // R SPI Master Out, Slave In
@@ -20,10 +22,50 @@
 // Refresh times.
 #define DMDESP_REFRESH_US 100
 
+// Scan ratios of panels: the number of phases that the rows are lit in.
+// Each phase lights DMDESP_NUM_ROWS / phases rows, and the phase is
+// chosen with address lines A, B, C and D as needed.
+#define DMD_SCAN_2 2   // Indoor panels, A only.
+#define DMD_SCAN_4 4   // The usual P10 panels, A and B.
+#define DMD_SCAN_8 8   // A, B and C.
+#define DMD_SCAN_16 16 // A, B, C and D.
+
+// By default the rows of a phase are spaced "phases" apart and their
+// bytes are sent bottom row first, so a 1/4 scan panel sends rows 12, 8,
+// 4 and 0 in phase 0.  Panels wired another way are described to
+// setRowOrder() with a table of DMDESP_NUM_ROWS panel rows: the rows of
+// phase 0 in the order that they are sent, then those of phase 1 and so
+// on.
+
+// Orientation of a panel in a DMDPanel layout.
+#define DMD_PANEL_NORMAL 0x00
+#define DMD_PANEL_ROTATE_180 0x01 // Panel is upside down.
+#define DMD_PANEL_MIRROR 0x02     // Columns run right to left.
+
+// Where a panel in the chain sits in the display.  Panel 0 of a layout is
+// the one plugged into the DMDESP board, and each panel after it is fed
+// from the output of the one before.
+struct DMDPanel
+{
+    uint8_t x;     // Column of the panel in the display, in panels.
+    uint8_t y;     // Row of the panel in the display, in panels.
+    uint8_t flags; // DMD_PANEL_ROTATE_180 and DMD_PANEL_MIRROR.
+};
+
+// Fills "row" with row "y" of a display "width" pixels wide, MSB first with
+// 1 = pixel on, for a DMDESP in row mode.
+typedef void (*DMDRowSource)(int y, uint8_t *row, int width, void *context);
+
 class DMDESP : public Bitmap
 {
 public:
-    explicit DMDESP(int widthPanels = 1, int heightPanels = 1);
+    explicit DMDESP(int widthPanels = 1, int heightPanels = 1, uint8_t scan = DMD_SCAN_4);
+
+    // Row mode: there is no frame buffer to draw on, and the rows are
+    // asked for from "source" as they are needed instead.  The rows of the
+    // next phase are asked for inside refresh(), so "source" must make
+    // them well within DMDESP_REFRESH_US or the display slows and flickers.
+    DMDESP(int widthPanels, int heightPanels, DMDRowSource source, void *context = 0, uint8_t scan = DMD_SCAN_4);
     ~DMDESP();
 
     bool IsUseDoubleBuffer() const { return useDoubleBuffer; }
@@ -31,12 +73,18 @@ public:
     void swapBuffers();
     void swapBuffersAndCopy();
 
+    bool setPanelLayout(const DMDPanel *panels, uint8_t count);
+    bool setRowOrder(const uint8_t *rows);
+
     void start();
     void refresh();
     void loop();
 
     void setBrightness(uint8_t brightness);
 
+    uint8_t getScan() const { return scanPhases; }
+    DMDRowSource getRowSource() const { return rowSource; }
+
 private:
     // Disable copy constructor and operator=().
     DMDESP(const DMDESP &other) : Bitmap(other) {}
@@ -45,10 +93,47 @@ private:
     uint8_t brightness;
     bool useDoubleBuffer;
     uint8_t phase;
+    uint8_t scanPhases;
+    uint8_t panelsWide;
+    uint8_t panelsHigh;
     uint8_t *fb0;
     uint8_t *fb1;
     uint8_t *displayfb;
     uint64_t lastRefresh;
+
+    // Panels next to each other in the chain and in the frame buffer are
+    // sent as one run, so a plain grid costs one run per row of panels.
+    struct ScanRun
+    {
+        int offset;     // First byte of the run's top row in phase 0.
+        int phaseStep;  // Added to "offset" for each phase.
+        int rowStep;    // From one row of a phase to the next.
+        uint16_t count; // Bytes in each row of the run.
+        bool mirror;    // Send the bytes right to left, bit-reversed.
+    };
+
+    const DMDPanel *panelLayout;
+    ScanRun *scanRuns;
+    uint8_t numScanRuns;
+
+    // Offsets of the rows in "rowOrder" from the top row of a panel the
+    // right way up [0], and from the bottom row of one upside down [1].
+    const uint8_t *rowOrder;
+    int16_t rowOffsets[2][DMDESP_NUM_ROWS];
+
+    // In row mode "displayfb" is a buffer of the rows for the next phase,
+    // in slots of DMDESP_NUM_ROWS / phases rows.  Each slot is for a row
+    // of panels the right way up (row * 2) or upside down (row * 2 + 1).
+    DMDRowSource rowSource;
+    void *rowContext;
+    uint8_t *rowSlots;
+    uint8_t numRowSlots;
+
+    void init();
+    bool compileLayout();
+    void generateRows();
+    template <uint8_t Rows>
+    void sendPhase();
 };
 
 #endif
@@ -0,0 +1,124 @@
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "DigitField.h"
+
+DigitField::DigitField(uint8_t length)
+    : cells(0), next(0), length(length), pad(' '), drawn(false), x(0), y(0), font(0), color(White), scale(1)
+{
+    // One buffer holds the cells on screen followed by the cells to draw.
+    cells = (char *)malloc(length * 2);
+    if (cells)
+        next = cells + length;
+}
+
+DigitField::~DigitField()
+{
+    if (cells)
+        free(cells);
+}
+
+void DigitField::setPosition(int x, int y)
+{
+    if (x != this->x || y != this->y)
+        drawn = false;
+    this->x = x;
+    this->y = y;
+}
+
+uint8_t DigitField::draw(Bitmap &bitmap, const char *str, int len)
+{
+    // Text is left-aligned and cut off at the end of the field.
+    if (!cells)
+        return 0;
+    if (len < 0)
+        len = strlen(str);
+    for (uint8_t posn = 0; posn < length; ++posn)
+        next[posn] = (posn < len) ? str[posn] : ' ';
+    return update(bitmap);
+}
+
+uint8_t DigitField::drawNumber(Bitmap &bitmap, long value, uint8_t decimals)
+{
+    // Numbers are right-aligned.  "decimals" digits of "value" go after
+    // the decimal point, so drawNumber(bitmap, 1234, 2) shows "12.34".
+    if (!cells)
+        return 0;
+    unsigned long magnitude = (value < 0) ? -((unsigned long)value) : value;
+    int posn = length;
+    uint8_t digits = 0;
+    do
+    {
+        if (decimals && digits == decimals && posn > 0)
+            next[--posn] = '.';
+        if (posn > 0)
+            next[--posn] = '0' + (magnitude % 10);
+        magnitude /= 10;
+        ++digits;
+    } while ((magnitude || digits <= decimals) && posn > 0);
+    if (magnitude || digits <= decimals || (value < 0 && posn == 0))
+    {
+        // The number does not fit, so fill the field with dashes.
+        memset(next, '-', length);
+        return update(bitmap);
+    }
+    if (value < 0 && pad == '0')
+    {
+        memset(next + 1, '0', posn - 1);
+        next[0] = '-';
+    }
+    else
+    {
+        if (value < 0)
+            next[--posn] = '-';
+        memset(next, pad, posn);
+    }
+    return update(bitmap);
+}
+
+uint8_t DigitField::drawClock(Bitmap &bitmap, uint8_t hours, uint8_t minutes, int seconds)
+{
+    // Shows "HH:MM", or "HH:MM:SS" if "seconds" is not negative.
+    char buf[8];
+    buf[0] = '0' + (hours / 10) % 10;
+    buf[1] = '0' + hours % 10;
+    buf[2] = ':';
+    buf[3] = '0' + (minutes / 10) % 10;
+    buf[4] = '0' + minutes % 10;
+    if (seconds < 0)
+        return draw(bitmap, buf, 5);
+    buf[5] = ':';
+    buf[6] = '0' + (seconds / 10) % 10;
+    buf[7] = '0' + seconds % 10;
+    return draw(bitmap, buf, 8);
+}
+
+uint8_t DigitField::update(Bitmap &bitmap)
+{
+    // Everything is redrawn if the font, colour, scale or position changed.
+    const uint8_t *currentFont = bitmap.getFont();
+    if (!currentFont)
+        return 0;
+    if (currentFont != font || bitmap.getTextColor() != color || bitmap.getTextScale() != scale)
+        drawn = false;
+    font = currentFont;
+    color = bitmap.getTextColor();
+    scale = bitmap.getTextScale();
+    int cellWidth = (bitmap.getFontInfo().width + 1) * scale;
+    int height = bitmap.getTextHeight();
+    uint8_t count = 0;
+    for (uint8_t posn = 0; posn < length; ++posn)
+    {
+        if (drawn && next[posn] == cells[posn])
+            continue;
+        int cx = x + posn * cellWidth;
+        int width = bitmap.drawChar(cx, y, next[posn]);
+        if (width < cellWidth)
+            bitmap.fill(cx + width, y, cellWidth - width, height, !color);
+        cells[posn] = next[posn];
+        ++count;
+    }
+    drawn = true;
+    return count;
+}
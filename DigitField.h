@@ -0,0 +1,50 @@
+#ifndef DigitField_h
+#define DigitField_h
+
+#include "Bitmap.h"
+
+// A row of fixed-size character cells for clocks and counters.  The field
+// remembers what each cell shows and only redraws the cells that change,
+// so a clock that ticks once a second usually redraws a single digit.
+// Cells are as wide as the font's nominal width plus a one column gap,
+// times the text scale, which suits the fixed-width fonts such as
+// fixednums8x16 and Mono5x7.
+// Numbers are formatted without String or sprintf().
+class DigitField
+{
+public:
+    explicit DigitField(uint8_t length = 8);
+    ~DigitField();
+
+    bool isValid() const { return cells != 0; }
+
+    uint8_t getLength() const { return length; }
+
+    void setPosition(int x, int y);
+    void setPadding(char pad) { this->pad = pad; }
+    void invalidate() { drawn = false; }
+
+    uint8_t draw(Bitmap &bitmap, const char *str, int len = -1);
+    uint8_t drawNumber(Bitmap &bitmap, long value, uint8_t decimals = 0);
+    uint8_t drawClock(Bitmap &bitmap, uint8_t hours, uint8_t minutes, int seconds = -1);
+
+private:
+    // Disable copy constructor and operator=().
+    DigitField(const DigitField &) {}
+    DigitField &operator=(const DigitField &) { return *this; }
+
+    char *cells;
+    char *next;
+    uint8_t length;
+    char pad;
+    bool drawn;
+    int16_t x;
+    int16_t y;
+    const uint8_t *font;
+    uint8_t color;
+    uint8_t scale;
+
+    uint8_t update(Bitmap &bitmap);
+};
+
+#endif
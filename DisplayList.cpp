@@ -0,0 +1,527 @@
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+#include <WString.h>
+
+#include "DisplayList.h"
+#include "FileFont.h"
+
+// Command opcodes.
+#define DL_CLEAR_SCREEN 0
+#define DL_FILL_SCREEN 1
+#define DL_SET_PIXEL 2
+#define DL_LINE 3
+#define DL_RECT 4
+#define DL_CIRCLE 5
+#define DL_BITMAP 6
+#define DL_SET_FONT 7
+#define DL_TEXT_COLOR 8
+#define DL_TEXT 9
+#define DL_TEXT_STRING 10
+#define DL_TEXT_FLASH 11
+#define DL_FILL 12
+#define DL_FILL_PATTERN 13
+#define DL_INVERT 14
+
+// Layout of each command after the opcode byte: number of 16-bit
+// arguments, number of color bytes, then an optional pointer, an optional
+// 16-bit length and optional inline text bytes.
+#define DL_ARGS(n) (n)
+#define DL_COLORS(n) ((n) << 3)
+#define DL_PTR 0x20
+#define DL_LEN 0x40
+#define DL_INLINE 0x80
+
+static const uint8_t commandFormats[] PROGMEM = {
+    0,                                          // DL_CLEAR_SCREEN
+    0,                                          // DL_FILL_SCREEN
+    DL_ARGS(2) | DL_COLORS(1),                  // DL_SET_PIXEL
+    DL_ARGS(4) | DL_COLORS(1),                  // DL_LINE
+    DL_ARGS(4) | DL_COLORS(2),                  // DL_RECT
+    DL_ARGS(3) | DL_COLORS(2),                  // DL_CIRCLE
+    DL_ARGS(2) | DL_COLORS(1) | DL_PTR,         // DL_BITMAP
+    DL_PTR,                                     // DL_SET_FONT
+    DL_COLORS(1),                               // DL_TEXT_COLOR
+    DL_ARGS(2) | DL_LEN | DL_INLINE,            // DL_TEXT
+    DL_ARGS(2) | DL_LEN | DL_INLINE,            // DL_TEXT_STRING
+    DL_ARGS(2) | DL_PTR | DL_LEN,               // DL_TEXT_FLASH
+    DL_ARGS(4) | DL_COLORS(1),                  // DL_FILL
+    DL_ARGS(4) | DL_COLORS(1) | DL_PTR,         // DL_FILL_PATTERN
+    DL_ARGS(4),                                 // DL_INVERT
+};
+
+#define isStateCommand(op) ((op) == DL_SET_FONT || (op) == DL_TEXT_COLOR)
+
+DisplayList::DisplayList(unsigned int size, uint8_t maxCommands)
+    : buffer(0), bounds(0), capacity(size), length(0), maxCommands(maxCommands), count(0), overflow(false), replayed(false), hash(2166136261UL), lastHash(0)
+{
+    buffer = (uint8_t *)malloc(size);
+    bounds = (Rect *)malloc(sizeof(Rect) * 2 * maxCommands);
+}
+
+DisplayList::~DisplayList()
+{
+    if (buffer)
+        free(buffer);
+    if (bounds)
+        free(bounds);
+}
+
+void DisplayList::clear()
+{
+    length = 0;
+    count = 0;
+    overflow = false;
+    hash = 2166136261UL;
+}
+
+void DisplayList::clearScreen()
+{
+    record(DL_CLEAR_SCREEN, 0, 0, 0, 0, 0, 0);
+}
+
+void DisplayList::fillScreen()
+{
+    record(DL_FILL_SCREEN, 0, 0, 0, 0, 0, 0);
+}
+
+void DisplayList::setPixel(int x, int y, uint8_t color)
+{
+    record(DL_SET_PIXEL, x, y, 0, 0, color, 0);
+}
+
+void DisplayList::drawLine(int x1, int y1, int x2, int y2, uint8_t color)
+{
+    record(DL_LINE, x1, y1, x2, y2, color, 0);
+}
+
+void DisplayList::drawRect(int x1, int y1, int x2, int y2, uint8_t borderColor, uint8_t fillColor)
+{
+    record(DL_RECT, x1, y1, x2, y2, borderColor, fillColor);
+}
+
+void DisplayList::drawFilledRect(int x1, int y1, int x2, int y2, uint8_t color)
+{
+    record(DL_RECT, x1, y1, x2, y2, color, color);
+}
+
+void DisplayList::drawCircle(int centerX, int centerY, int radius, uint8_t borderColor, uint8_t fillColor)
+{
+    record(DL_CIRCLE, centerX, centerY, radius, 0, borderColor, fillColor);
+}
+
+void DisplayList::drawFilledCircle(int centerX, int centerY, int radius, uint8_t color)
+{
+    record(DL_CIRCLE, centerX, centerY, radius, 0, color, color);
+}
+
+void DisplayList::drawBitmap(int x, int y, PGM_VOID_P bitmap, uint8_t color)
+{
+    record(DL_BITMAP, x, y, 0, 0, color, 0, bitmap);
+}
+
+void DisplayList::drawInvertedBitmap(int x, int y, PGM_VOID_P bitmap)
+{
+    record(DL_BITMAP, x, y, 0, 0, Black, 0, bitmap);
+}
+
+void DisplayList::setFont(const uint8_t *font)
+{
+    record(DL_SET_FONT, 0, 0, 0, 0, 0, 0, font);
+}
+
+void DisplayList::setTextColor(uint8_t color)
+{
+    record(DL_TEXT_COLOR, 0, 0, 0, 0, color, 0);
+}
+
+void DisplayList::drawString(int x, int y, const char *str, int len)
+{
+    if (len < 0)
+        len = strlen(str);
+    record(DL_TEXT, x, y, 0, 0, 0, 0, str, len);
+}
+
+void DisplayList::drawString(int x, int y, const String &str, int start, int len)
+{
+    if (len < 0)
+        len = str.length() - start;
+    if (len > 0)
+        record(DL_TEXT_STRING, x, y, 0, 0, 0, 0, str.c_str() + start, len);
+}
+
+void DisplayList::drawString_P(int x, int y, PGM_P str, int len)
+{
+    if (len < 0)
+        len = strlen_P(str);
+    record(DL_TEXT_FLASH, x, y, 0, 0, 0, 0, str, len);
+}
+
+void DisplayList::drawString_P(int x, int y, const __FlashStringHelper *str, int len)
+{
+    drawString_P(x, y, (PGM_P)str, len);
+}
+
+void DisplayList::fill(int x, int y, int width, int height, uint8_t color)
+{
+    record(DL_FILL, x, y, width, height, color, 0);
+}
+
+void DisplayList::fill(int x, int y, int width, int height, PGM_VOID_P pattern, uint8_t color)
+{
+    record(DL_FILL_PATTERN, x, y, width, height, color, 0, pattern);
+}
+
+void DisplayList::invert(int x, int y, int width, int height)
+{
+    record(DL_INVERT, x, y, width, height, 0, 0);
+}
+
+static inline void clipRect(const Bitmap &bitmap, int x1, int y1, int x2, int y2, int16_t *rect)
+{
+    if (x1 < 0)
+        x1 = 0;
+    if (y1 < 0)
+        y1 = 0;
+    if (x2 >= bitmap.getWidth())
+        x2 = bitmap.getWidth() - 1;
+    if (y2 >= bitmap.getHeight())
+        y2 = bitmap.getHeight() - 1;
+    if (x1 > x2 || y1 > y2)
+    {
+        // Empty rectangles always have x1 > x2.
+        x1 = 1;
+        x2 = 0;
+    }
+    rect[0] = x1;
+    rect[1] = y1;
+    rect[2] = x2;
+    rect[3] = y2;
+}
+
+uint8_t DisplayList::replay(Bitmap &bitmap)
+{
+    Command cmd;
+    unsigned int posn;
+    uint8_t index;
+
+    // First pass: work out the area that each drawing command touches and
+    // the area that it is guaranteed to paint over completely.  Text needs
+    // the font state at that point in the list to be measured.
+    const uint8_t *savedFont = bitmap.getFont();
+    FileFont *savedFile = bitmap.getFileFont();
+    uint8_t savedColor = bitmap.getTextColor();
+    posn = 0;
+    index = 0;
+    while (posn < length)
+    {
+        posn = decode(posn, cmd);
+        if (isStateCommand(cmd.op))
+        {
+            execute(bitmap, cmd);
+            clipRect(bitmap, 1, 0, 0, 0, &(bounds[index * 2].x1));
+            bounds[index * 2 + 1] = bounds[index * 2];
+        }
+        else
+        {
+            measure(bitmap, cmd, bounds[index * 2], bounds[index * 2 + 1]);
+        }
+        ++index;
+    }
+    if (savedFile)
+        bitmap.setFont(*savedFile);
+    else
+        bitmap.setFont(savedFont);
+    bitmap.setTextColor(savedColor);
+
+    // Second pass: working backwards, cull any command whose touched area
+    // lies inside the opaque area of a later command.
+    uint8_t total = index;
+    while (index-- > 0)
+    {
+        Rect &touched = bounds[index * 2];
+        Rect &opaque = bounds[index * 2 + 1];
+        if (touched.x1 > touched.x2)
+            continue;
+        for (uint8_t later = index + 1; later < total; ++later)
+        {
+            const Rect &cover = bounds[later * 2 + 1];
+            if (cover.x1 <= touched.x1 && cover.y1 <= touched.y1 &&
+                cover.x2 >= touched.x2 && cover.y2 >= touched.y2)
+            {
+                touched.x1 = 1;
+                touched.x2 = 0;
+                opaque.x1 = 1;
+                opaque.x2 = 0;
+                break;
+            }
+        }
+    }
+
+    // Third pass: draw the commands that survived.
+    uint8_t drawn = 0;
+    posn = 0;
+    index = 0;
+    while (posn < length)
+    {
+        posn = decode(posn, cmd);
+        if (isStateCommand(cmd.op) || bounds[index * 2].x1 <= bounds[index * 2].x2)
+        {
+            execute(bitmap, cmd);
+            ++drawn;
+        }
+        ++index;
+    }
+    replayed = true;
+    lastHash = hash;
+    return drawn;
+}
+
+bool DisplayList::replayIfChanged(Bitmap &bitmap)
+{
+    if (!isChanged())
+        return false;
+    replay(bitmap);
+    return true;
+}
+
+void DisplayList::record(uint8_t op, int a0, int a1, int a2, int a3, uint8_t color1, uint8_t color2, const void *ptr, int len)
+{
+    uint8_t format = pgm_read_byte(&(commandFormats[op]));
+    uint8_t nargs = format & 0x07;
+    uint8_t ncolors = (format >> 3) & 0x03;
+    unsigned int size = 1 + nargs * 2 + ncolors;
+    if (format & DL_PTR)
+        size += sizeof(ptr);
+    if (format & DL_LEN)
+        size += 2;
+    if (format & DL_INLINE)
+        size += len;
+    if (overflow || count >= maxCommands || (length + size) > capacity || len > 0xFFFF)
+    {
+        overflow = true;
+        return;
+    }
+    int16_t args[4] = {(int16_t)a0, (int16_t)a1, (int16_t)a2, (int16_t)a3};
+    uint8_t colors[2] = {color1, color2};
+    uint16_t len16 = (uint16_t)len;
+    put(&op, 1);
+    put(args, nargs * 2);
+    put(colors, ncolors);
+    if (format & DL_PTR)
+        put(&ptr, sizeof(ptr));
+    if (format & DL_LEN)
+        put(&len16, 2);
+    if (format & DL_INLINE)
+        put(ptr, len);
+    ++count;
+}
+
+void DisplayList::put(const void *data, unsigned int size)
+{
+    // Append to the buffer and update the FNV-1a hash of the list.
+    const uint8_t *d = (const uint8_t *)data;
+    uint8_t *out = buffer + length;
+    uint32_t h = hash;
+    length += size;
+    while (size-- > 0)
+    {
+        h ^= *d;
+        h *= 16777619UL;
+        *out++ = *d++;
+    }
+    hash = h;
+}
+
+unsigned int DisplayList::decode(unsigned int posn, Command &cmd) const
+{
+    cmd.op = buffer[posn++];
+    uint8_t format = pgm_read_byte(&(commandFormats[cmd.op]));
+    uint8_t nargs = format & 0x07;
+    uint8_t ncolors = (format >> 3) & 0x03;
+    memcpy(cmd.args, buffer + posn, nargs * 2);
+    posn += nargs * 2;
+    cmd.color1 = ncolors > 0 ? buffer[posn] : 0;
+    cmd.color2 = ncolors > 1 ? buffer[posn + 1] : 0;
+    posn += ncolors;
+    cmd.ptr = 0;
+    cmd.len = 0;
+    if (format & DL_PTR)
+    {
+        memcpy(&cmd.ptr, buffer + posn, sizeof(cmd.ptr));
+        posn += sizeof(cmd.ptr);
+    }
+    if (format & DL_LEN)
+    {
+        uint16_t len16;
+        memcpy(&len16, buffer + posn, 2);
+        cmd.len = len16;
+        posn += 2;
+    }
+    if (format & DL_INLINE)
+    {
+        cmd.ptr = buffer + posn;
+        posn += cmd.len;
+    }
+    return posn;
+}
+
+void DisplayList::measure(const Bitmap &bitmap, const Command &cmd, Rect &touched, Rect &opaque)
+{
+    const int16_t *a = cmd.args;
+    int width = 0;
+    int height = 0;
+    int shortest = 0;
+    bool isOpaque = true;
+    int x1, y1, x2, y2;
+    switch (cmd.op)
+    {
+    case DL_CLEAR_SCREEN:
+    case DL_FILL_SCREEN:
+        x1 = 0;
+        y1 = 0;
+        x2 = bitmap.getWidth() - 1;
+        y2 = bitmap.getHeight() - 1;
+        break;
+
+    case DL_SET_PIXEL:
+        x1 = x2 = a[0];
+        y1 = y2 = a[1];
+        break;
+
+    case DL_LINE:
+    case DL_RECT:
+        x1 = a[0] < a[2] ? a[0] : a[2];
+        y1 = a[1] < a[3] ? a[1] : a[3];
+        x2 = a[0] < a[2] ? a[2] : a[0];
+        y2 = a[1] < a[3] ? a[3] : a[1];
+        isOpaque = (cmd.op == DL_RECT && cmd.color2 != NoFill);
+        break;
+
+    case DL_CIRCLE:
+    {
+        int radius = a[2] < 0 ? -a[2] : a[2];
+        x1 = a[0] - radius;
+        y1 = a[1] - radius;
+        x2 = a[0] + radius;
+        y2 = a[1] + radius;
+        isOpaque = false;
+        break;
+    }
+
+    case DL_BITMAP:
+        x1 = a[0];
+        y1 = a[1];
+        x2 = x1 + pgm_read_byte(cmd.ptr) - 1;
+        y2 = y1 + pgm_read_byte((const uint8_t *)cmd.ptr + 1) - 1;
+        break;
+
+    case DL_TEXT:
+    case DL_TEXT_STRING:
+    case DL_TEXT_FLASH:
+        if (!bitmap.getFont() || cmd.len <= 0)
+        {
+            x1 = 1;
+            y1 = 0;
+            x2 = 0;
+            y2 = 0;
+            break;
+        }
+        // Text from a char array is followed by a gap.
+        if (cmd.op == DL_TEXT_FLASH)
+            width = bitmap.getTextWidth_P((PGM_P)cmd.ptr, cmd.len) + bitmap.getTextScale();
+        else if (cmd.op == DL_TEXT)
+            width = bitmap.getTextWidth((const char *)cmd.ptr, cmd.len) + bitmap.getTextScale();
+        else
+            width = bitmap.getTextWidth((const char *)cmd.ptr, cmd.len);
+        x1 = a[0];
+        y1 = a[1];
+        x2 = x1 + width - 1;
+
+        // Glyphs from fallback fonts only paint their own font's height, so
+        // the text may touch the rows of the tallest font but only hides the
+        // rows of the shortest.
+        height = bitmap.getTextHeight();
+        shortest = height;
+        for (uint8_t index = 0; index < bitmap.getFallbackFontCount(); ++index)
+        {
+            int fallbackHeight = bitmap.getFallbackFontInfo(index).height * bitmap.getTextScale();
+            if (fallbackHeight > height)
+                height = fallbackHeight;
+            if (fallbackHeight < shortest)
+                shortest = fallbackHeight;
+        }
+        y2 = y1 + height - 1;
+
+        // Fonts less than 8 pixels high may also touch the row below.
+        clipRect(bitmap, x1, y1, x2, y2 + 1, &(touched.x1));
+        clipRect(bitmap, x1, y1, x2, y1 + shortest - 1, &(opaque.x1));
+        return;
+
+    default:
+        x1 = a[0];
+        y1 = a[1];
+        x2 = x1 + a[2] - 1;
+        y2 = y1 + a[3] - 1;
+        isOpaque = (cmd.op != DL_INVERT);
+        break;
+    }
+    clipRect(bitmap, x1, y1, x2, y2, &(touched.x1));
+    if (isOpaque)
+        opaque = touched;
+    else
+        clipRect(bitmap, 1, 0, 0, 0, &(opaque.x1));
+}
+
+void DisplayList::execute(Bitmap &bitmap, const Command &cmd)
+{
+    const int16_t *a = cmd.args;
+    switch (cmd.op)
+    {
+    case DL_CLEAR_SCREEN:
+        bitmap.clearScreen();
+        break;
+    case DL_FILL_SCREEN:
+        bitmap.fillScreen();
+        break;
+    case DL_SET_PIXEL:
+        bitmap.setPixel(a[0], a[1], cmd.color1);
+        break;
+    case DL_LINE:
+        bitmap.drawLine(a[0], a[1], a[2], a[3], cmd.color1);
+        break;
+    case DL_RECT:
+        bitmap.drawRect(a[0], a[1], a[2], a[3], cmd.color1, cmd.color2);
+        break;
+    case DL_CIRCLE:
+        bitmap.drawCircle(a[0], a[1], a[2], cmd.color1, cmd.color2);
+        break;
+    case DL_BITMAP:
+        bitmap.drawBitmap(a[0], a[1], cmd.ptr, cmd.color1);
+        break;
+    case DL_SET_FONT:
+        bitmap.setFont((const uint8_t *)cmd.ptr);
+        break;
+    case DL_TEXT_COLOR:
+        bitmap.setTextColor(cmd.color1);
+        break;
+    case DL_TEXT:
+        bitmap.drawString(a[0], a[1], (const char *)cmd.ptr, cmd.len);
+        break;
+    case DL_TEXT_STRING:
+        bitmap.drawText(a[0], a[1], (const char *)cmd.ptr, cmd.len);
+        break;
+    case DL_TEXT_FLASH:
+        bitmap.drawString_P(a[0], a[1], (PGM_P)cmd.ptr, cmd.len);
+        break;
+    case DL_FILL:
+        bitmap.fill(a[0], a[1], a[2], a[3], cmd.color1);
+        break;
+    case DL_FILL_PATTERN:
+        bitmap.fill(a[0], a[1], a[2], a[3], cmd.ptr, cmd.color1);
+        break;
+    case DL_INVERT:
+        bitmap.invert(a[0], a[1], a[2], a[3]);
+        break;
+    }
+}
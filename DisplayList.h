@@ -0,0 +1,98 @@
+#ifndef DisplayList_h
+#define DisplayList_h
+
+#include "Bitmap.h"
+
+// Records Bitmap drawing calls into a compact command buffer so that a
+// frame can be replayed later.  Commands that are completely hidden by a
+// later opaque command are skipped on replay, and a frame that is identical
+// to the last one replayed can be skipped altogether.
+class DisplayList
+{
+public:
+    explicit DisplayList(unsigned int size = 512, uint8_t maxCommands = 64);
+    ~DisplayList();
+
+    bool isValid() const { return buffer != 0 && bounds != 0; }
+    bool isOverflowed() const { return overflow; }
+
+    unsigned int size() const { return length; }
+    uint8_t commandCount() const { return count; }
+
+    void clear();
+
+    void clearScreen();
+    void fillScreen();
+
+    void setPixel(int x, int y, uint8_t color);
+
+    void drawLine(int x1, int y1, int x2, int y2, uint8_t color = White);
+    void drawRect(int x1, int y1, int x2, int y2, uint8_t borderColor = White, uint8_t fillColor = NoFill);
+    void drawFilledRect(int x1, int y1, int x2, int y2, uint8_t color = White);
+    void drawCircle(int centerX, int centerY, int radius, uint8_t borderColor = White, uint8_t fillColor = NoFill);
+    void drawFilledCircle(int centerX, int centerY, int radius, uint8_t color = White);
+
+    void drawBitmap(int x, int y, PGM_VOID_P bitmap, uint8_t color = White);
+    void drawInvertedBitmap(int x, int y, PGM_VOID_P bitmap);
+
+    void setFont(const uint8_t *font);
+    void setTextColor(uint8_t color);
+
+    void drawString(int x, int y, const char *str, int len = -1);
+    void drawString(int x, int y, const String &str, int start = 0, int len = -1);
+    void drawString_P(int x, int y, PGM_P str, int len = -1);
+    void drawString_P(int x, int y, const __FlashStringHelper *str, int len = -1);
+
+    void fill(int x, int y, int width, int height, uint8_t color);
+    void fill(int x, int y, int width, int height, PGM_VOID_P pattern, uint8_t color = White);
+
+    void invert(int x, int y, int width, int height);
+
+    bool isChanged() const { return !replayed || hash != lastHash; }
+
+    uint8_t replay(Bitmap &bitmap);
+    bool replayIfChanged(Bitmap &bitmap);
+
+private:
+    // Disable copy constructor and operator=().
+    DisplayList(const DisplayList &) {}
+    DisplayList &operator=(const DisplayList &) { return *this; }
+
+    struct Rect
+    {
+        int16_t x1;
+        int16_t y1;
+        int16_t x2;
+        int16_t y2;
+    };
+
+    struct Command
+    {
+        uint8_t op;
+        uint8_t color1;
+        uint8_t color2;
+        int16_t args[4];
+        const void *ptr;
+        int len;
+    };
+
+    uint8_t *buffer;
+    Rect *bounds;
+    unsigned int capacity;
+    unsigned int length;
+    uint8_t maxCommands;
+    uint8_t count;
+    bool overflow;
+    bool replayed;
+    uint32_t hash;
+    uint32_t lastHash;
+
+    void record(uint8_t op, int a0, int a1, int a2, int a3, uint8_t color1, uint8_t color2, const void *ptr = 0, int len = 0);
+    void put(const void *data, unsigned int size);
+
+    unsigned int decode(unsigned int posn, Command &cmd) const;
+    static void measure(const Bitmap &bitmap, const Command &cmd, Rect &touched, Rect &opaque);
+    static void execute(Bitmap &bitmap, const Command &cmd);
+};
+
+#endif
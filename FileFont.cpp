@@ -0,0 +1,102 @@
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FileFont.h"
+#include "FontStorage.h"
+
+#define FILEFONT_NO_PAGE 0xFFFFFFFFUL
+
+FileFont::FileFont(uint8_t pages, uint16_t pageSize)
+    : storage(0), pageData(0), pageStart(0), order(0), pageCount(pages), pageBytes(pageSize), numHits(0), numMisses(0)
+{
+    if (!pageCount)
+        pageCount = 1;
+    if (pageBytes < 16)
+        pageBytes = 16;
+    pageData = (uint8_t *)malloc((unsigned int)pageCount * pageBytes);
+    pageStart = (uint32_t *)malloc(sizeof(uint32_t) * pageCount);
+    order = (uint8_t *)malloc(pageCount);
+    if (!pageData || !pageStart || !order)
+    {
+        free(pageData);
+        free(pageStart);
+        free(order);
+        pageData = 0;
+        pageStart = 0;
+        order = 0;
+        pageCount = 0;
+    }
+    clear();
+}
+
+FileFont::~FileFont()
+{
+    free(pageData);
+    free(pageStart);
+    free(order);
+}
+
+void FileFont::setStorage(FontStorage *storage)
+{
+    this->storage = storage;
+    clear();
+}
+
+void FileFont::resetStats()
+{
+    numHits = 0;
+    numMisses = 0;
+}
+
+void FileFont::clear()
+{
+    for (uint8_t temp = 0; temp < pageCount; ++temp)
+    {
+        pageStart[temp] = FILEFONT_NO_PAGE;
+        order[temp] = temp;
+    }
+}
+
+uint8_t FileFont::readByte(uint32_t offset)
+{
+    uint16_t avail;
+    return *page(offset, avail);
+}
+
+const uint8_t *FileFont::page(uint32_t offset, uint16_t &avail)
+{
+    // Returns a pointer to the byte at "offset" and the number of bytes
+    // after it in the same page.  Bytes that cannot be read are zero.
+    static uint8_t zero = 0;
+    if (!pageCount)
+    {
+        avail = 1;
+        return &zero;
+    }
+    uint32_t start = offset - (offset % pageBytes);
+    avail = pageBytes - (offset - start);
+    uint8_t posn = 0;
+    while (posn < pageCount && pageStart[order[posn]] != start)
+        ++posn;
+    if (posn < pageCount)
+    {
+        ++numHits;
+    }
+    else
+    {
+        // Load the page over the least recently used one.
+        ++numMisses;
+        posn = pageCount - 1;
+        uint8_t *data = pageData + (unsigned int)order[posn] * pageBytes;
+        uint16_t len = storage ? storage->read(start, data, pageBytes) : 0;
+        memset(data + len, 0, pageBytes - len);
+        pageStart[order[posn]] = start;
+    }
+
+    // Move the page to the front of the list.
+    uint8_t index = order[posn];
+    memmove(order + 1, order, posn);
+    order[0] = index;
+    return pageData + (unsigned int)index * pageBytes + (offset - start);
+}
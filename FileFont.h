@@ -0,0 +1,101 @@
+#ifndef FileFont_h
+#define FileFont_h
+
+#include <stddef.h>
+#include <string.h>
+#include <inttypes.h>
+
+class FontStorage;
+
+// A font read from a FontStorage, such as a file on LittleFS, instead of
+// being compiled into PROGMEM.  Reads go through a cache of fixed-size
+// pages, so drawing text costs a few lookups in RAM once the pages are
+// loaded and memory use is limited to the pages.  Pass the FileFont to
+// Bitmap::setFont() or Bitmap::addFallbackFont() after setting its
+// storage, and select it again if the storage changes.
+class FileFont
+{
+public:
+    explicit FileFont(uint8_t pages = 4, uint16_t pageSize = 64);
+    ~FileFont();
+
+    bool isValid() const { return pageData != 0; }
+
+    FontStorage *getStorage() const { return storage; }
+    void setStorage(FontStorage *storage);
+
+    uint8_t numPages() const { return pageCount; }
+    uint16_t pageSize() const { return pageBytes; }
+
+    uint32_t hits() const { return numHits; }
+    uint32_t misses() const { return numMisses; }
+    void resetStats();
+
+    uint8_t readByte(uint32_t offset);
+    const uint8_t *page(uint32_t offset, uint16_t &avail);
+
+private:
+    // Disable copy constructor and operator=().
+    FileFont(const FileFont &) {}
+    FileFont &operator=(const FileFont &) { return *this; }
+
+    FontStorage *storage;
+    uint8_t *pageData;
+    uint32_t *pageStart; // File offset of each page, FILEFONT_NO_PAGE if empty.
+    uint8_t *order;      // Pages from most to least recently used.
+    uint8_t pageCount;
+    uint16_t pageBytes;
+    uint32_t numHits;
+    uint32_t numMisses;
+
+    void clear();
+};
+
+// Reads a FileFont in order through its page cache, in the same way that
+// FlashReader reads PROGMEM.
+class FileFontReader
+{
+public:
+    FileFontReader(FileFont *font, uint32_t offset)
+        : font(font), offset(offset), ptr(0), avail(0) {}
+
+    uint8_t readByte()
+    {
+        if (!avail)
+            ptr = font->page(offset, avail);
+        ++offset;
+        --avail;
+        return *ptr++;
+    }
+
+    void readBytes(uint8_t *dest, size_t len)
+    {
+        // Copy as much of each page as possible in one go.
+        while (len > 0)
+        {
+            if (!avail)
+                ptr = font->page(offset, avail);
+            uint16_t count = (len < avail) ? len : avail;
+            memcpy(dest, ptr, count);
+            dest += count;
+            ptr += count;
+            offset += count;
+            avail -= count;
+            len -= count;
+        }
+    }
+
+    void skip(size_t len)
+    {
+        offset += len;
+        avail = 0;
+    }
+
+private:
+    FileFont *font;
+    uint32_t offset;
+    const uint8_t *ptr;
+    uint16_t avail;
+};
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef FlashReader_h
+#define FlashReader_h
+
+#include <Arduino.h>
+
+// Reads bytes from PROGMEM in order.  Flash on the ESP8266 can only be
+// read an aligned 32-bit word at a time, so every call to pgm_read_byte()
+// loads, shifts and masks a whole word.  The reader loads each word once
+// and hands out its bytes from a register instead, which suits data that
+// is read from start to end such as glyphs and bitmaps.
+class FlashReader
+{
+public:
+    explicit FlashReader(PGM_VOID_P addr) { seek(addr); }
+
+    void seek(PGM_VOID_P addr)
+    {
+        uintptr_t posn = (uintptr_t)addr;
+        ptr = (const uint32_t *)(posn & ~((uintptr_t)3));
+        word = pgm_read_dword(ptr) >> ((posn & 3) * 8);
+        avail = 4 - (posn & 3);
+    }
+
+    const uint8_t *position() const { return ((const uint8_t *)ptr) + 4 - avail; }
+
+    uint8_t readByte()
+    {
+        if (!avail)
+        {
+            word = pgm_read_dword(++ptr);
+            avail = 4;
+        }
+        uint8_t value = (uint8_t)word;
+        word >>= 8;
+        --avail;
+        return value;
+    }
+
+    char next() { return (char)readByte(); }
+
+    void readBytes(uint8_t *dest, size_t len)
+    {
+        while (len-- > 0)
+            *dest++ = readByte();
+    }
+
+    void skip(size_t len) { seek(position() + len); }
+
+private:
+    const uint32_t *ptr;
+    uint32_t word;
+    uint8_t avail;
+};
+
+// Hands out runs of bits, MSB first, from the bytes of a reader such as
+// FlashReader.  Bits are taken from whole bytes, so the reader should not
+// be used directly part way through.
+template <typename Reader>
+class BitReader
+{
+public:
+    explicit BitReader(Reader &reader) : reader(reader), bits(0), bitCount(0) {}
+
+    // Returns the next "count" bits, up to 8.
+    uint8_t readBits(uint8_t count)
+    {
+        if (bitCount < count)
+        {
+            bits = (bits << 8) | reader.readByte();
+            bitCount += 8;
+        }
+        bitCount -= count;
+        return (bits >> bitCount) & ((1 << count) - 1);
+    }
+
+    void skipBits(unsigned int count)
+    {
+        while (count > 8)
+        {
+            readBits(8);
+            count -= 8;
+        }
+        readBits(count);
+    }
+
+private:
+    Reader &reader;
+    uint16_t bits;
+    uint8_t bitCount;
+};
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef FontMetrics_h
+#define FontMetrics_h
+
+#include "Bitmap.h"
+
+// Measures string literals at compile time, so that static screens can be
+// laid out without measuring text at run time.  Fonts must be declared
+// constexpr, as the fonts in fonts/ and those from tools/fontconv.py are.
+// Widths match Bitmap::getTextWidth() with the same font, except that
+// fallback fonts are not searched.
+//
+//     constexpr int x = FontMetrics::centerX(Arial14, "OPEN", 32);
+//
+// The functions read the font as ordinary memory, which only works at
+// compile time as flash on the ESP8266 must be read a word at a time.
+// Use them to initialize constexpr values, or through CONST_TEXT_WIDTH()
+// and CONST_TEXT_CENTER(), which do not compile unless the result is a
+// constant.
+class FontMetrics
+{
+public:
+    static constexpr int height(const uint8_t *font) { return font[3]; }
+
+    static constexpr int charWidth(const uint8_t *font, uint32_t code)
+    {
+        return code == ' ' ? spaceWidth(font) : glyphWidth(font, glyphIndex(font, code));
+    }
+
+    static constexpr int textWidth(const uint8_t *font, const char *str)
+    {
+        // One column between characters but not after the last, as drawn.
+        return !str[0] ? 0 : charWidth(font, codePoint(str)) +
+                   (str[sequenceLength(str)] ? 1 + textWidth(font, str + sequenceLength(str)) : 0);
+    }
+
+    static constexpr int centerX(const uint8_t *font, const char *str, int width)
+    {
+        return (width - textWidth(font, str)) / 2;
+    }
+
+private:
+    static constexpr uint16_t readLE16(const uint8_t *ptr) { return ptr[0] | (ptr[1] << 8); }
+    static constexpr uint32_t readLE32(const uint8_t *ptr)
+    {
+        return readLE16(ptr) | (((uint32_t)readLE16(ptr + 2)) << 16);
+    }
+
+    static constexpr uint8_t flags(const uint8_t *font)
+    {
+        return font[0] == FONT_EXT_MARKER ? font[6] : 0;
+    }
+
+    static constexpr int glyphCount(const uint8_t *font)
+    {
+        return (flags(font) & FONT_FLAG_RANGES) ? readLE16(font + sizeof(ExtFontHeader)) :
+               (flags(font) & FONT_FLAG_MAP) ? font[sizeof(ExtFontHeader)] : font[5];
+    }
+
+    // Start of the glyph offsets of an extended font.
+    static constexpr const uint8_t *offsets(const uint8_t *font)
+    {
+        return (flags(font) & FONT_FLAG_RANGES) ? ranges(font) + readLE16(font + sizeof(ExtFontHeader) + 2) * sizeof(FontRange) :
+               (flags(font) & FONT_FLAG_MAP) ? font + sizeof(ExtFontHeader) + 1 + font[5] :
+               font + sizeof(ExtFontHeader);
+    }
+
+    static constexpr const uint8_t *ranges(const uint8_t *font) { return font + sizeof(ExtFontHeader) + 4; }
+
+    // Returns the index of the glyph for "code", or -1 if there is none.
+    static constexpr int glyphIndex(const uint8_t *font, uint32_t code)
+    {
+        return (flags(font) & FONT_FLAG_RANGES) ? rangeIndex(ranges(font), readLE16(font + sizeof(ExtFontHeader) + 2), code) :
+               (code < font[4] || code >= ((uint32_t)font[4] + font[5])) ? -1 :
+               (flags(font) & FONT_FLAG_MAP) ? mapIndex(font, font[sizeof(ExtFontHeader) + 1 + (code - font[4])]) :
+               (int)(code - font[4]);
+    }
+
+    static constexpr int mapIndex(const uint8_t *font, uint8_t index)
+    {
+        return index >= glyphCount(font) ? -1 : index;
+    }
+
+    static constexpr int rangeIndex(const uint8_t *range, int count, uint32_t code)
+    {
+        return !count ? -1 :
+               (code >= readLE32(range) && code < (readLE32(range) + readLE16(range + 4))) ?
+                   readLE16(range + 6) + (int)(code - readLE32(range)) :
+                   rangeIndex(range + sizeof(FontRange), count - 1, code);
+    }
+
+    static constexpr int glyphWidth(const uint8_t *font, int index)
+    {
+        return index < 0 ? 0 :
+               font[0] == FONT_EXT_MARKER ? offsets(font)[(glyphCount(font) + 1) * 2 + index] :
+               (font[0] == 0 && font[1] == 0) ? font[2] : font[6 + index];
+    }
+
+    // Spaces are as wide as 'n', as in Bitmap::getSpaceWidth().
+    static constexpr int spaceWidth(const uint8_t *font)
+    {
+        return glyphIndex(font, 'n') >= 0 ? glyphWidth(font, glyphIndex(font, 'n')) :
+                                            glyphWidth(font, glyphIndex(font, ' '));
+    }
+
+    // UTF-8 is decoded as in Bitmap::decodeUtf8(), with bytes that do not
+    // start a valid sequence taken as Latin-1.
+    static constexpr int extraBytes(uint8_t ch)
+    {
+        return (ch < 0xC2 || ch > 0xF4) ? 0 : (ch >= 0xF0 ? 3 : (ch >= 0xE0 ? 2 : 1));
+    }
+
+    static constexpr bool isContinued(const char *str, int count)
+    {
+        return !count || ((((uint8_t)str[0]) & 0xC0) == 0x80 && isContinued(str + 1, count - 1));
+    }
+
+    static constexpr int sequenceLength(const char *str)
+    {
+        return isContinued(str + 1, extraBytes(str[0])) ? 1 + extraBytes(str[0]) : 1;
+    }
+
+    static constexpr uint32_t decodeTail(const char *str, int count, uint32_t code)
+    {
+        return !count ? code : decodeTail(str + 1, count - 1, (code << 6) | (((uint8_t)str[0]) & 0x3F));
+    }
+
+    static constexpr uint32_t codePoint(const char *str)
+    {
+        return sequenceLength(str) == 1 ? (uint8_t)str[0] :
+               decodeTail(str + 1, sequenceLength(str) - 1,
+                          ((uint8_t)str[0]) & (0x3F >> (sequenceLength(str) - 1)));
+    }
+};
+
+// Holds a FontMetrics result as a constant, so that it can never be worked
+// out at run time.
+template <int Value>
+struct FontMetricsConstant
+{
+    enum { value = Value };
+};
+
+#define CONST_TEXT_WIDTH(font, str) (FontMetricsConstant<FontMetrics::textWidth((font), (str))>::value)
+#define CONST_TEXT_CENTER(font, str, width) (FontMetricsConstant<FontMetrics::centerX((font), (str), (width))>::value)
+
+#endif
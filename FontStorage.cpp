@@ -0,0 +1,62 @@
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FontStorage.h"
+
+#if defined(ARDUINO)
+
+uint32_t FsFontStorage::size()
+{
+    return file ? file.size() : 0;
+}
+
+uint16_t FsFontStorage::read(uint32_t offset, uint8_t *data, uint16_t len)
+{
+    if (!file || !file.seek(offset))
+        return 0;
+    return file.read(data, len);
+}
+
+#else
+
+StdioFontStorage::StdioFontStorage(const char *path, const char *root)
+    : file(0)
+{
+    if (!root)
+    {
+        file = fopen(path, "rb");
+        return;
+    }
+    char *name = (char *)malloc(strlen(root) + strlen(path) + 2);
+    if (!name)
+        return;
+    strcpy(name, root);
+    strcat(name, "/");
+    strcat(name, path);
+    file = fopen(name, "rb");
+    free(name);
+}
+
+StdioFontStorage::~StdioFontStorage()
+{
+    if (file)
+        fclose(file);
+}
+
+uint32_t StdioFontStorage::size()
+{
+    if (!file || fseek(file, 0, SEEK_END) != 0)
+        return 0;
+    long len = ftell(file);
+    return len > 0 ? len : 0;
+}
+
+uint16_t StdioFontStorage::read(uint32_t offset, uint8_t *data, uint16_t len)
+{
+    if (!file || fseek(file, offset, SEEK_SET) != 0)
+        return 0;
+    return fread(data, 1, len, file);
+}
+
+#endif
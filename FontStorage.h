@@ -0,0 +1,68 @@
+#ifndef FontStorage_h
+#define FontStorage_h
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#if defined(ARDUINO)
+#include <FS.h>
+#endif
+
+// Somewhere other than PROGMEM that a FileFont can read a font from, such
+// as a file on LittleFS.  Fonts are the output of tools/fontconv.py saved
+// with a .fnt extension.
+class FontStorage
+{
+public:
+    virtual ~FontStorage() {}
+
+    virtual uint32_t size() = 0;
+
+    // Reads up to "len" bytes at "offset" and returns the number read.
+    virtual uint16_t read(uint32_t offset, uint8_t *data, uint16_t len) = 0;
+};
+
+#if defined(ARDUINO)
+
+// Font in a file on LittleFS, SPIFFS or SD opened with FS::open().
+class FsFontStorage : public FontStorage
+{
+public:
+    explicit FsFontStorage(const fs::File &file) : file(file) {}
+
+    bool isValid() { return (bool)file; }
+
+    uint32_t size();
+    uint16_t read(uint32_t offset, uint8_t *data, uint16_t len);
+
+private:
+    fs::File file;
+};
+
+#else
+
+// Font in a file read with stdio, which stands in for LittleFS when the
+// library is built on a PC.  Paths are relative to "root", if it is not 0,
+// so a directory can play the part of the file system.
+class StdioFontStorage : public FontStorage
+{
+public:
+    explicit StdioFontStorage(const char *path, const char *root = 0);
+    ~StdioFontStorage();
+
+    bool isValid() const { return file != 0; }
+
+    uint32_t size();
+    uint16_t read(uint32_t offset, uint8_t *data, uint16_t len);
+
+private:
+    // Disable copy constructor and operator=().
+    StdioFontStorage(const StdioFontStorage &) {}
+    StdioFontStorage &operator=(const StdioFontStorage &) { return *this; }
+
+    FILE *file;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,167 @@
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "GlyphCache.h"
+
+#define GLYPH_NONE 0xFF
+
+GlyphCache::GlyphCache(uint8_t size, uint16_t glyphBytes)
+    : entries(0), buckets(0), data(0), numEntries(size), bucketMask(0), head(GLYPH_NONE), tail(GLYPH_NONE), slotSize(glyphBytes), numHits(0), numMisses(0)
+{
+    if (numEntries >= GLYPH_NONE)
+        numEntries = GLYPH_NONE - 1;
+
+    // Use a power of two number of hash buckets, about one per entry.
+    uint8_t numBuckets = 1;
+    while (numBuckets < numEntries && numBuckets < 128)
+        numBuckets <<= 1;
+    bucketMask = numBuckets - 1;
+
+    entries = (Entry *)malloc(sizeof(Entry) * numEntries);
+    buckets = (uint8_t *)malloc(numBuckets);
+    data = (uint8_t *)malloc((unsigned int)numEntries * slotSize);
+    if (!entries || !buckets || !data)
+    {
+        free(entries);
+        free(buckets);
+        free(data);
+        entries = 0;
+        buckets = 0;
+        data = 0;
+        numEntries = 0;
+    }
+    clear();
+}
+
+GlyphCache::~GlyphCache()
+{
+    free(entries);
+    free(buckets);
+    free(data);
+}
+
+void GlyphCache::clear()
+{
+    if (!buckets)
+        return;
+    memset(buckets, GLYPH_NONE, bucketMask + 1);
+
+    // Put every entry on the LRU list as unused, so that they are handed
+    // out from the tail before anything is evicted.
+    head = GLYPH_NONE;
+    tail = GLYPH_NONE;
+    for (uint8_t entry = 0; entry < numEntries; ++entry)
+    {
+        entries[entry].font = 0;
+        entries[entry].chain = GLYPH_NONE;
+        pushFront(entry);
+    }
+}
+
+void GlyphCache::resetStats()
+{
+    numHits = 0;
+    numMisses = 0;
+}
+
+const uint8_t *GlyphCache::find(const void *font, uint16_t index)
+{
+    uint8_t entry = numEntries ? buckets[hash(font, index)] : GLYPH_NONE;
+    while (entry != GLYPH_NONE)
+    {
+        Entry &e = entries[entry];
+        if (e.font == font && e.index == index)
+        {
+            if (entry != head)
+            {
+                unlink(entry);
+                pushFront(entry);
+            }
+            ++numHits;
+            return data + entry * slotSize;
+        }
+        entry = e.chain;
+    }
+    ++numMisses;
+    return 0;
+}
+
+bool GlyphCache::lookup(const void *font, uint16_t index, uint8_t &width, uint8_t &height) const
+{
+    // Gets the size of a cached glyph without counting a hit or making it
+    // the most recently used, so that text can be measured from the cache.
+    uint8_t entry = numEntries ? buckets[hash(font, index)] : GLYPH_NONE;
+    while (entry != GLYPH_NONE)
+    {
+        const Entry &e = entries[entry];
+        if (e.font == font && e.index == index)
+        {
+            width = e.width;
+            height = e.height;
+            return true;
+        }
+        entry = e.chain;
+    }
+    return false;
+}
+
+uint8_t *GlyphCache::insert(const void *font, uint16_t index, uint8_t width, uint8_t height)
+{
+    if (!numEntries || ((unsigned int)((width + 7) >> 3)) * height > slotSize)
+        return 0;
+
+    // Evict the least recently used entry from its hash bucket.
+    uint8_t entry = tail;
+    Entry &e = entries[entry];
+    if (e.font)
+    {
+        uint8_t *link = &(buckets[hash(e.font, e.index)]);
+        while (*link != entry)
+            link = &(entries[*link].chain);
+        *link = e.chain;
+    }
+
+    // Fill in the entry and make it the most recently used.
+    uint8_t bucket = hash(font, index);
+    e.font = font;
+    e.index = index;
+    e.width = width;
+    e.height = height;
+    e.chain = buckets[bucket];
+    buckets[bucket] = entry;
+    unlink(entry);
+    pushFront(entry);
+    return data + entry * slotSize;
+}
+
+uint8_t GlyphCache::hash(const void *font, uint16_t index) const
+{
+    uintptr_t value = (uintptr_t)font;
+    return (uint8_t)((value >> 2) ^ (value >> 9) ^ index) & bucketMask;
+}
+
+void GlyphCache::unlink(uint8_t entry)
+{
+    Entry &e = entries[entry];
+    if (e.prev != GLYPH_NONE)
+        entries[e.prev].next = e.next;
+    else
+        head = e.next;
+    if (e.next != GLYPH_NONE)
+        entries[e.next].prev = e.prev;
+    else
+        tail = e.prev;
+}
+
+void GlyphCache::pushFront(uint8_t entry)
+{
+    Entry &e = entries[entry];
+    e.prev = GLYPH_NONE;
+    e.next = head;
+    if (head != GLYPH_NONE)
+        entries[head].prev = entry;
+    else
+        tail = entry;
+    head = entry;
+}
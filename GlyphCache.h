@@ -0,0 +1,63 @@
+#ifndef GlyphCache_h
+#define GlyphCache_h
+
+#include <inttypes.h>
+
+// Fixed-size RAM cache of rasterized glyphs for Bitmap's text functions.
+// Glyphs are kept in the same row-major layout as the frame buffer and are
+// looked up by font and character.  The least recently used glyph is
+// evicted when the cache is full.
+class GlyphCache
+{
+public:
+    explicit GlyphCache(uint8_t size = 32, uint16_t glyphBytes = 64);
+    ~GlyphCache();
+
+    bool isValid() const { return entries != 0 && data != 0; }
+
+    uint8_t size() const { return numEntries; }
+    uint16_t glyphBytes() const { return slotSize; }
+
+    void clear();
+
+    uint32_t hits() const { return numHits; }
+    uint32_t misses() const { return numMisses; }
+    void resetStats();
+
+    const uint8_t *find(const void *font, uint16_t index);
+    bool lookup(const void *font, uint16_t index, uint8_t &width, uint8_t &height) const;
+    uint8_t *insert(const void *font, uint16_t index, uint8_t width, uint8_t height);
+
+private:
+    // Disable copy constructor and operator=().
+    GlyphCache(const GlyphCache &) {}
+    GlyphCache &operator=(const GlyphCache &) { return *this; }
+
+    struct Entry
+    {
+        const void *font;
+        uint16_t index;
+        uint8_t width;
+        uint8_t height;
+        uint8_t prev;  // Previous entry in LRU order, towards most recent.
+        uint8_t next;  // Next entry in LRU order, towards least recent.
+        uint8_t chain; // Next entry in the same hash bucket.
+    };
+
+    Entry *entries;
+    uint8_t *buckets;
+    uint8_t *data;
+    uint8_t numEntries;
+    uint8_t bucketMask;
+    uint8_t head;
+    uint8_t tail;
+    uint16_t slotSize;
+    uint32_t numHits;
+    uint32_t numMisses;
+
+    uint8_t hash(const void *font, uint16_t index) const;
+    void unlink(uint8_t entry);
+    void pushFront(uint8_t entry);
+};
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef ImageBuilder_h
+#define ImageBuilder_h
+
+#include <stddef.h>
+#include <inttypes.h>
+
+// Image in the format that Bitmap::drawBitmap() reads from PROGMEM: a byte
+// of width, a byte of height and then the rows, MSB first, 1 = color.
+template <size_t Size>
+struct ProgmemImage
+{
+    uint8_t data[Size];
+};
+
+template <size_t... Indexes>
+struct ImageIndexes
+{
+};
+
+template <typename First, typename Second>
+struct ImageIndexesJoin;
+
+template <size_t... First, size_t... Second>
+struct ImageIndexesJoin<ImageIndexes<First...>, ImageIndexes<Second...> >
+{
+    typedef ImageIndexes<First..., (sizeof...(First) + Second)...> type;
+};
+
+// ImageIndexes<0, 1, ..., Count - 1>, built by halves to keep the template
+// nesting shallow for large images.
+template <size_t Count>
+struct MakeImageIndexes
+{
+    typedef typename ImageIndexesJoin<typename MakeImageIndexes<Count / 2>::type,
+                                      typename MakeImageIndexes<Count - Count / 2>::type>::type type;
+};
+
+template <>
+struct MakeImageIndexes<0>
+{
+    typedef ImageIndexes<> type;
+};
+
+template <>
+struct MakeImageIndexes<1>
+{
+    typedef ImageIndexes<0> type;
+};
+
+// Builds images for drawBitmap() at compile time, so they need not be
+// packed by hand:
+//
+//     static constexpr auto Bell PROGMEM = ImageBuilder::fromArt<5>(
+//         "..#.."
+//         ".###."
+//         ".###."
+//         "#####"
+//         "..#..");
+//     display.drawBitmap(0, 0, Bell.data);
+//
+// In ASCII art ' ', '.', '-', '_' and '0' are pixels that are off and any
+// other character is a pixel that is on.  XBM images can be used by
+// declaring their bits "static constexpr unsigned char" and passing them
+// with their width and height to fromXbm().
+class ImageBuilder
+{
+public:
+    template <uint8_t Width, size_t Length>
+    static constexpr ProgmemImage<2 + ((Width + 7) >> 3) * ((Length - 1) / Width)>
+    fromArt(const char (&art)[Length])
+    {
+        static_assert(Width > 0, "image width must not be zero");
+        static_assert(((Length - 1) % Width) == 0, "ASCII art must be whole rows of Width characters");
+        static_assert(((Length - 1) / Width) <= 255, "image must be at most 255 rows");
+        return artImage<Width, (Length - 1) / Width>(
+            art, typename MakeImageIndexes<((Width + 7) >> 3) * ((Length - 1) / Width)>::type());
+    }
+
+    template <uint8_t Width, uint8_t Height, size_t Length>
+    static constexpr ProgmemImage<2 + ((Width + 7) >> 3) * Height>
+    fromXbm(const unsigned char (&bits)[Length])
+    {
+        static_assert(Length >= (size_t)((Width + 7) >> 3) * Height, "XBM data is smaller than Width x Height");
+        return xbmImage<Width, Height>(
+            bits, typename MakeImageIndexes<((Width + 7) >> 3) * Height>::type());
+    }
+
+private:
+    static constexpr bool isPixelOn(char ch)
+    {
+        return ch != ' ' && ch != '.' && ch != '-' && ch != '_' && ch != '0';
+    }
+
+    // Packs the 8 pixels of "row" from column "x" into a byte, MSB first.
+    static constexpr uint8_t artBits(const char *row, int width, int x, int bit)
+    {
+        return bit == 8 ? 0 :
+               (uint8_t)(((x < width && isPixelOn(row[x])) ? (0x80 >> bit) : 0) |
+                         artBits(row, width, x + 1, bit + 1));
+    }
+
+    static constexpr uint8_t artByte(const char *art, int width, size_t index)
+    {
+        return artBits(art + (index / ((width + 7) >> 3)) * width, width,
+                       (index % ((width + 7) >> 3)) * 8, 0);
+    }
+
+    template <uint8_t Width, uint8_t Height, size_t... Indexes>
+    static constexpr ProgmemImage<2 + sizeof...(Indexes)>
+    artImage(const char *art, ImageIndexes<Indexes...>)
+    {
+        return ProgmemImage<2 + sizeof...(Indexes)>{{Width, Height, artByte(art, Width, Indexes)...}};
+    }
+
+    // XBM stores the leftmost pixel in bit 0 of each byte.
+    static constexpr uint8_t reverseBits(uint8_t value)
+    {
+        return (uint8_t)(((value & 0x01) << 7) | ((value & 0x02) << 5) |
+                         ((value & 0x04) << 3) | ((value & 0x08) << 1) |
+                         ((value & 0x10) >> 1) | ((value & 0x20) >> 3) |
+                         ((value & 0x40) >> 5) | ((value & 0x80) >> 7));
+    }
+
+    template <uint8_t Width, uint8_t Height, size_t... Indexes>
+    static constexpr ProgmemImage<2 + sizeof...(Indexes)>
+    xbmImage(const unsigned char *bits, ImageIndexes<Indexes...>)
+    {
+        return ProgmemImage<2 + sizeof...(Indexes)>{{Width, Height, reverseBits(bits[Indexes])...}};
+    }
+};
+
+#endif
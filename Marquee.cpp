@@ -0,0 +1,126 @@
+#include <Arduino.h>
+#include <WString.h>
+
+#include "Marquee.h"
+
+Marquee::Marquee()
+    : strip(0), textWidth(0), textHeight(0), gap(0), position(0), textColor(White), loop(false)
+{
+}
+
+Marquee::~Marquee()
+{
+    delete strip;
+}
+
+bool Marquee::setText(const uint8_t *font, const char *str, int len)
+{
+    // A bitmap without pixels is enough to measure the text.
+    Bitmap measure(0, 0);
+    measure.setFont(font);
+    if (!allocStrip(measure, measure.getTextWidth(str, len)))
+        return false;
+    if (strip)
+        strip->drawString(0, 0, str, len);
+    return true;
+}
+
+bool Marquee::setText(const uint8_t *font, const String &str)
+{
+    return setText(font, str.c_str(), str.length());
+}
+
+bool Marquee::setText_P(const uint8_t *font, PGM_P str, int len)
+{
+    Bitmap measure(0, 0);
+    measure.setFont(font);
+    if (!allocStrip(measure, measure.getTextWidth_P(str, len)))
+        return false;
+    if (strip)
+        strip->drawString_P(0, 0, str, len);
+    return true;
+}
+
+bool Marquee::setText_P(const uint8_t *font, const __FlashStringHelper *str, int len)
+{
+    return setText_P(font, (PGM_P)str, len);
+}
+
+void Marquee::clear()
+{
+    delete strip;
+    strip = 0;
+    textWidth = 0;
+    position = 0;
+}
+
+void Marquee::draw(Bitmap &bitmap, int x, int y, int width) const
+{
+    int cycle = textWidth + gap;
+    int col = 0;
+    while (col < width)
+    {
+        // Find the column of the text that is at column "col" of the window
+        // and copy as many columns as possible from there in one go.
+        int posn = position - width + col;
+        if (posn >= 0 && loop && cycle > 0)
+            posn %= cycle;
+        int count;
+        if (posn >= 0 && posn < textWidth)
+        {
+            count = textWidth - posn;
+            if (count > (width - col))
+                count = width - col;
+            strip->copy(posn, 0, count, textHeight, &bitmap, x + col, y);
+        }
+        else
+        {
+            if (posn < 0)
+                count = -posn;
+            else if (loop && cycle > 0)
+                count = cycle - posn;
+            else
+                count = width - col;
+            if (count > (width - col))
+                count = width - col;
+            bitmap.fill(x + col, y, count, textHeight, !textColor);
+        }
+        col += count;
+    }
+}
+
+bool Marquee::step(Bitmap &bitmap, int x, int y, int width, int dx)
+{
+    position += dx;
+    int cycle = textWidth + gap;
+    if (loop && cycle > 0 && (position - width) >= cycle)
+        position -= cycle;
+    draw(bitmap, x, y, width);
+    return loop || position < (width + textWidth);
+}
+
+bool Marquee::allocStrip(const Bitmap &measure, int width)
+{
+    delete strip;
+    strip = 0;
+    textWidth = 0;
+    textHeight = measure.getTextHeight();
+    position = 0;
+    if (width <= 0 || textHeight == 0)
+        return true;
+    strip = new Bitmap(width, textHeight);
+    if (!strip || !strip->isValid())
+    {
+        delete strip;
+        strip = 0;
+        return false;
+    }
+    if (textColor)
+        strip->clearScreen();
+    else
+        strip->fillScreen();
+    strip->setFont(measure.getFont());
+    strip->setTextColor(textColor);
+    textWidth = width;
+    return true;
+}
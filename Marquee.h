@@ -0,0 +1,60 @@
+#ifndef Marquee_h
+#define Marquee_h
+
+#include "Bitmap.h"
+
+// Scrolls a line of text through a window of a Bitmap.  The text is
+// rendered once into an off-screen strip, and each step copies a window
+// of the strip into the destination a row at a time, so the cost of a
+// step does not depend on the font or the text.
+//
+// The text enters at the right edge of the window and leaves at the left.
+// When looping, it comes round again after "gap" blank columns.
+class Marquee
+{
+public:
+    Marquee();
+    ~Marquee();
+
+    bool setText(const uint8_t *font, const char *str, int len = -1);
+    bool setText(const uint8_t *font, const String &str);
+    bool setText_P(const uint8_t *font, PGM_P str, int len = -1);
+    bool setText_P(const uint8_t *font, const __FlashStringHelper *str, int len = -1);
+    void clear();
+
+    uint8_t getTextColor() const { return textColor; }
+    void setTextColor(uint8_t color) { textColor = color; }
+
+    bool isLooping() const { return loop; }
+    void setLoop(bool loop) { this->loop = loop; }
+
+    int getGap() const { return gap; }
+    void setGap(int gap) { this->gap = gap > 0 ? gap : 0; }
+
+    int getTextWidth() const { return textWidth; }
+    int getTextHeight() const { return textHeight; }
+
+    int getPosition() const { return position; }
+    void setPosition(int position) { this->position = position; }
+    void reset() { position = 0; }
+
+    void draw(Bitmap &bitmap, int x, int y, int width) const;
+    bool step(Bitmap &bitmap, int x, int y, int width, int dx = 1);
+
+private:
+    // Disable copy constructor and operator=().
+    Marquee(const Marquee &) {}
+    Marquee &operator=(const Marquee &) { return *this; }
+
+    Bitmap *strip;
+    int textWidth;
+    int textHeight;
+    int gap;
+    int position;
+    uint8_t textColor;
+    bool loop;
+
+    bool allocStrip(const Bitmap &measure, int width);
+};
+
+#endif
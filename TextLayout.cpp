@@ -0,0 +1,194 @@
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "TextLayout.h"
+
+TextLayout::TextLayout(uint8_t maxLines)
+    : lines(0), maxLines(maxLines), numLines(0), boxX(0), boxY(0), boxWidth(0), boxHeight(0), align(TEXT_ALIGN_LEFT), wrap(TEXT_WRAP_WORD), spacing(1), fontHeight(0), valid(false), font(0), text(0), length(0), hash(0)
+{
+    lines = (Line *)malloc(sizeof(Line) * maxLines);
+}
+
+TextLayout::~TextLayout()
+{
+    if (lines)
+        free(lines);
+}
+
+void TextLayout::setBox(int x, int y, int width, int height)
+{
+    if (width != boxWidth)
+        valid = false;
+    boxX = x;
+    boxY = y;
+    boxWidth = width;
+    boxHeight = height;
+}
+
+void TextLayout::setAlignment(uint8_t align)
+{
+    // Alignment does not change the line breaks, only where lines go.
+    this->align = align;
+}
+
+void TextLayout::setWrap(uint8_t wrap)
+{
+    if (wrap != this->wrap)
+        valid = false;
+    this->wrap = wrap;
+}
+
+void TextLayout::setLineSpacing(uint8_t spacing)
+{
+    this->spacing = spacing;
+}
+
+static uint32_t hashText(const char *text, int len)
+{
+    uint32_t h = 2166136261UL;
+    while (len-- > 0)
+    {
+        h ^= (uint8_t)(*text++);
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+bool TextLayout::layout(const Bitmap &bitmap, const char *str, int len)
+{
+    if (!lines)
+        return false;
+    if (len < 0)
+        len = strlen(str);
+
+    // Reuse the previous layout if the text and font have not changed.
+    uint32_t h = hashText(str, len);
+    if (valid && font == bitmap.getFont() && fontHeight == bitmap.getTextHeight() &&
+        text == str && length == len && hash == h)
+        return false;
+    font = bitmap.getFont();
+    text = str;
+    length = len;
+    hash = h;
+    fontHeight = bitmap.getTextHeight();
+    numLines = 0;
+    valid = true;
+    if (!font)
+        return true;
+
+    // Single pass over the text, remembering the last place that the
+    // line could have been broken at a space.
+    int start = 0;
+    int width = 0;
+    int breakPosn = -1;
+    int breakWidth = 0;
+    int posn = 0;
+    while (posn < len && numLines < maxLines)
+    {
+        const char *next = str + posn;
+        int remaining = len - posn;
+        uint32_t code = Bitmap::decodeUtf8(next, remaining);
+        int nextPosn = next - str;
+        if (code == '\n')
+        {
+            addLine(start, posn, width);
+            start = posn = nextPosn;
+            width = 0;
+            breakPosn = -1;
+            continue;
+        }
+        int charWidth = bitmap.getCodePointWidth(code);
+        int newWidth = (posn > start) ? width + bitmap.getTextScale() + charWidth : charWidth;
+        if (newWidth > boxWidth && posn > start && wrap != TEXT_WRAP_NONE)
+        {
+            if (wrap == TEXT_WRAP_WORD && breakPosn > start)
+            {
+                // Break at the last space and carry the partial word over.
+                addLine(start, breakPosn, breakWidth);
+                posn = breakPosn;
+            }
+            else
+            {
+                addLine(start, posn, width);
+            }
+            while (posn < len && str[posn] == ' ')
+                ++posn;
+            start = posn;
+            width = 0;
+            breakPosn = -1;
+            continue;
+        }
+        if (code == ' ' && (posn == start || str[posn - 1] != ' '))
+        {
+            breakPosn = posn;
+            breakWidth = width;
+        }
+        width = newWidth;
+        posn = nextPosn;
+    }
+    if (posn > start && numLines < maxLines)
+        addLine(start, posn, width);
+    return true;
+}
+
+void TextLayout::addLine(int start, int end, int width)
+{
+    Line &line = lines[numLines++];
+    line.start = start;
+    line.length = end - start;
+    line.width = width;
+}
+
+int TextLayout::lineX(uint8_t line) const
+{
+    int x = boxX;
+    if (align & TEXT_ALIGN_CENTER)
+        x += (boxWidth - lines[line].width) / 2;
+    else if (align & TEXT_ALIGN_RIGHT)
+        x += boxWidth - lines[line].width;
+    return x;
+}
+
+int TextLayout::lineY(uint8_t line) const
+{
+    int y = boxY;
+    if (align & (TEXT_ALIGN_MIDDLE | TEXT_ALIGN_BOTTOM))
+    {
+        int height = numLines * (fontHeight + spacing) - spacing;
+        if (height > boxHeight)
+            height = boxHeight; // Too many lines, so start at the top.
+        if (align & TEXT_ALIGN_MIDDLE)
+            y += (boxHeight - height) / 2;
+        else
+            y += boxHeight - height;
+    }
+    return y + line * (fontHeight + spacing);
+}
+
+void TextLayout::draw(Bitmap &bitmap, const char *str, int len)
+{
+    layout(bitmap, str, len);
+    if (!font)
+        return;
+    uint8_t invColor = !bitmap.getTextColor();
+    uint8_t gap = bitmap.getTextScale();
+    for (uint8_t line = 0; line < numLines; ++line)
+    {
+        int y = lineY(line);
+        if (y + fontHeight > boxY + boxHeight)
+            break; // No room for any more lines in the box.
+        int x = lineX(line);
+        const char *posn = str + lines[line].start;
+        int count = lines[line].length;
+        while (count > 0)
+        {
+            x += bitmap.drawCodePoint(x, y, Bitmap::decodeUtf8(posn, count));
+            if (count > 0)
+            {
+                bitmap.fill(x, y, gap, fontHeight, invColor);
+                x += gap;
+            }
+        }
+    }
+}
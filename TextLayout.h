@@ -0,0 +1,80 @@
+#ifndef TextLayout_h
+#define TextLayout_h
+
+#include "Bitmap.h"
+
+// Horizontal alignment of each line within the text box.
+#define TEXT_ALIGN_LEFT 0x00
+#define TEXT_ALIGN_CENTER 0x01
+#define TEXT_ALIGN_RIGHT 0x02
+
+// Vertical alignment of the block of lines within the text box.
+#define TEXT_ALIGN_TOP 0x00
+#define TEXT_ALIGN_MIDDLE 0x04
+#define TEXT_ALIGN_BOTTOM 0x08
+
+// Line wrapping modes.
+#define TEXT_WRAP_NONE 0 // Only break lines at '\n'.
+#define TEXT_WRAP_WORD 1 // Break at spaces, or mid-word if a word is too long.
+#define TEXT_WRAP_CHAR 2 // Break at any character.
+
+// Lays out text in a box with word wrap and alignment.  The line breaks
+// and line widths are kept until the text, font, text scale or box
+// changes, so that redrawing the same text only costs the glyph rendering.
+class TextLayout
+{
+public:
+    explicit TextLayout(uint8_t maxLines = 8);
+    ~TextLayout();
+
+    bool isValid() const { return lines != 0; }
+
+    void setBox(int x, int y, int width, int height);
+    void setAlignment(uint8_t align);
+    void setWrap(uint8_t wrap);
+    void setLineSpacing(uint8_t spacing);
+
+    bool layout(const Bitmap &bitmap, const char *text, int len = -1);
+    void draw(Bitmap &bitmap, const char *text, int len = -1);
+    void invalidate() { valid = false; }
+
+    uint8_t lineCount() const { return numLines; }
+    int lineStart(uint8_t line) const { return lines[line].start; }
+    int lineLength(uint8_t line) const { return lines[line].length; }
+    int lineWidth(uint8_t line) const { return lines[line].width; }
+    int lineX(uint8_t line) const;
+    int lineY(uint8_t line) const;
+
+private:
+    // Disable copy constructor and operator=().
+    TextLayout(const TextLayout &) {}
+    TextLayout &operator=(const TextLayout &) { return *this; }
+
+    struct Line
+    {
+        uint16_t start;
+        uint16_t length;
+        int16_t width;
+    };
+
+    Line *lines;
+    uint8_t maxLines;
+    uint8_t numLines;
+    int16_t boxX;
+    int16_t boxY;
+    int16_t boxWidth;
+    int16_t boxHeight;
+    uint8_t align;
+    uint8_t wrap;
+    uint8_t spacing;
+    int16_t fontHeight;
+    bool valid;
+    const uint8_t *font;
+    const char *text;
+    int length;
+    uint32_t hash;
+
+    void addLine(int start, int end, int width);
+};
+
+#endif
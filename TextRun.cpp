@@ -0,0 +1,89 @@
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+#include <WString.h>
+
+#include "TextRun.h"
+
+TextRun::TextRun(uint8_t maxGlyphs)
+    : glyphs(0), maxGlyphs(maxGlyphs), count(0), runWidth(0), runHeight(0), runScale(1)
+{
+    glyphs = (RunGlyph *)malloc(sizeof(RunGlyph) * maxGlyphs);
+}
+
+TextRun::~TextRun()
+{
+    if (glyphs)
+        free(glyphs);
+}
+
+bool TextRun::set(const Bitmap &bitmap, const char *str, int len)
+{
+    // Returns false if the string had more characters than the run holds,
+    // in which case the run keeps as many as fit.
+    clear();
+    if (!glyphs || !bitmap.getFont())
+        return false;
+    runHeight = bitmap.getTextHeight();
+    runScale = bitmap.getTextScale();
+    if (len < 0)
+        len = strlen(str);
+    int x = 0;
+    bool truncated = false;
+    while (len > 0)
+    {
+        if (count >= maxGlyphs)
+        {
+            truncated = true;
+            break;
+        }
+        uint32_t code = Bitmap::decodeUtf8(str, len);
+        RunGlyph &entry = glyphs[count];
+        if (code == ' ' || !bitmap.resolveGlyph(code, entry.glyph))
+        {
+            // Missing characters take no space, just as in drawString().
+            entry.glyph.font = 0;
+            entry.glyph.width = (code == ' ') ? bitmap.getSpaceWidth() : 0;
+        }
+        entry.x = x;
+        x += (entry.glyph.width + 1) * runScale;
+        ++count;
+    }
+    runWidth = count ? x - runScale : 0;
+    return !truncated;
+}
+
+bool TextRun::set(const Bitmap &bitmap, const String &str, int start, int len)
+{
+    if (len < 0)
+        len = str.length() - start;
+    return set(bitmap, str.c_str() + start, len);
+}
+
+void TextRun::clear()
+{
+    count = 0;
+    runWidth = 0;
+    runHeight = 0;
+    runScale = 1;
+}
+
+void TextRun::draw(Bitmap &bitmap, int x, int y) const
+{
+    // Draws the run in the bitmap's colour, with a gap between characters
+    // but not after the last one.
+    uint8_t invColor = !bitmap.getTextColor();
+    for (uint8_t index = 0; index < count; ++index)
+    {
+        const RunGlyph &entry = glyphs[index];
+        int posn = x + entry.x;
+        if (posn >= bitmap.getWidth())
+            break;
+        if (entry.glyph.font)
+            bitmap.drawGlyph(posn, y, entry.glyph);
+        else if (entry.glyph.width)
+            bitmap.fill(posn, y, entry.glyph.width * runScale, runHeight, invColor);
+        if ((index + 1) < count)
+            bitmap.fill(posn + entry.glyph.width * runScale, y, runScale, runHeight, invColor);
+    }
+}
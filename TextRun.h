@@ -0,0 +1,50 @@
+#ifndef TextRun_h
+#define TextRun_h
+
+#include "Bitmap.h"
+
+// A string that has been looked up in a font once, for labels that are
+// drawn over and over.  The glyph, width and position of every character
+// are kept, so measuring the run is free and drawing it goes straight to
+// the glyph data.  The run must be set again if the font or text scale
+// changes.
+class TextRun
+{
+public:
+    explicit TextRun(uint8_t maxGlyphs = 32);
+    ~TextRun();
+
+    bool isValid() const { return glyphs != 0; }
+
+    bool set(const Bitmap &bitmap, const char *str, int len = -1);
+    bool set(const Bitmap &bitmap, const String &str, int start = 0, int len = -1);
+    void clear();
+
+    uint8_t length() const { return count; }
+    int width() const { return runWidth; }
+    int height() const { return runHeight; }
+    int glyphX(uint8_t index) const { return glyphs[index].x; }
+    int glyphWidth(uint8_t index) const { return glyphs[index].glyph.width * runScale; }
+
+    void draw(Bitmap &bitmap, int x, int y) const;
+
+private:
+    // Disable copy constructor and operator=().
+    TextRun(const TextRun &) {}
+    TextRun &operator=(const TextRun &) { return *this; }
+
+    struct RunGlyph
+    {
+        Bitmap::Glyph glyph; // glyph.font is 0 for spaces.
+        int16_t x;
+    };
+
+    RunGlyph *glyphs;
+    uint8_t maxGlyphs;
+    uint8_t count;
+    int16_t runWidth;
+    int16_t runHeight;
+    uint8_t runScale;
+};
+
+#endif
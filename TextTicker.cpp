@@ -0,0 +1,205 @@
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "TextTicker.h"
+
+TextTicker::TextTicker(uint16_t size)
+    : ring(0), size(size), head(0), count(0), rows(0), rowsSize(0), glyphWidth(0), glyphHeight(0), glyphStride(0), glyphScale(1), column(1), blank(true), regionX(0), regionY(0), regionWidth(0)
+{
+    ring = (char *)malloc(size);
+}
+
+TextTicker::~TextTicker()
+{
+    if (ring)
+        free(ring);
+    if (rows)
+        free(rows);
+}
+
+void TextTicker::setRegion(int x, int y, int width)
+{
+    regionX = x;
+    regionY = y;
+    regionWidth = width;
+}
+
+size_t TextTicker::write(uint8_t ch)
+{
+    if (!ring || count >= size)
+        return 0;
+    uint16_t posn = head + count;
+    if (posn >= size)
+        posn -= size;
+    ring[posn] = ch;
+    ++count;
+    return 1;
+}
+
+size_t TextTicker::write(const char *str, int len)
+{
+    if (len < 0)
+        len = strlen(str);
+    size_t written = 0;
+    while (len-- > 0 && write((uint8_t)(*str++)))
+        ++written;
+    return written;
+}
+
+void TextTicker::clear()
+{
+    // Drop the queued text, but let the glyph in progress finish.
+    head = 0;
+    count = 0;
+}
+
+bool TextTicker::step(Bitmap &bitmap)
+{
+    if (!bitmap.getFont())
+        return false;
+    int x = regionX;
+    int y = regionY;
+    int width = regionWidth;
+    int height = bitmap.getTextHeight();
+    if (x < 0)
+    {
+        width += x;
+        x = 0;
+    }
+    if ((x + width) > bitmap.getWidth())
+        width = bitmap.getWidth() - x;
+    if (y < 0)
+    {
+        height += y;
+        y = 0;
+    }
+    if ((y + height) > bitmap.getHeight())
+        height = bitmap.getHeight() - y;
+    if (width <= 0 || height <= 0)
+        return false;
+
+    // Each glyph is followed by a gap, as in drawString().  Columns are
+    // counted after scaling.
+    bool active = true;
+    if (column >= (glyphWidth + 1) * glyphScale)
+        active = nextGlyph(bitmap);
+    shiftLeft(bitmap, x, y, width, height);
+    uint8_t color = bitmap.getTextColor();
+    int cx = x + width - 1;
+    if (!active || blank || column >= glyphWidth * glyphScale)
+    {
+        bitmap.fill(cx, y, 1, height, !color);
+    }
+    else
+    {
+        // Glyph rows start at the top of the region, not at the top of
+        // the clipped part of it.
+        int skip = y - regionY;
+        uint16_t source = column / glyphScale;
+        const uint8_t *ptr = rows + (source >> 3);
+        uint8_t mask = 0x80 >> (source & 0x07);
+        for (int cy = skip; cy < (skip + height); ++cy)
+        {
+            // Fallback fonts may be shorter than the bitmap's font.
+            int row = cy / glyphScale;
+            if (row < glyphHeight && (ptr[row * glyphStride] & mask))
+                bitmap.setPixel(cx, y + cy - skip, color);
+            else
+                bitmap.setPixel(cx, y + cy - skip, !color);
+        }
+    }
+    if (active)
+        ++column;
+    return active;
+}
+
+bool TextTicker::nextGlyph(Bitmap &bitmap)
+{
+    // Decode the next character, waiting for the rest of a UTF-8
+    // sequence if only part of it has arrived.
+    if (!count)
+        return false;
+    char buf[4];
+    uint8_t lead = ring[head];
+    int need = 1;
+    if (lead >= 0xF0 && lead <= 0xF7)
+        need = 4;
+    else if (lead >= 0xE0)
+        need = 3;
+    else if (lead >= 0xC0)
+        need = 2;
+    if (need > count)
+        return false;
+    for (int temp = 0; temp < need; ++temp)
+    {
+        uint16_t posn = head + temp;
+        if (posn >= size)
+            posn -= size;
+        buf[temp] = ring[posn];
+    }
+    const char *str = buf;
+    int len = need;
+    uint32_t code = Bitmap::decodeUtf8(str, len);
+    int used = str - buf;
+    head += used;
+    if (head >= size)
+        head -= size;
+    count -= used;
+
+    column = 0;
+    blank = true;
+    glyphWidth = 0;
+    glyphScale = bitmap.getTextScale();
+    if (code == ' ')
+    {
+        glyphWidth = bitmap.getSpaceWidth();
+        return true;
+    }
+    Bitmap::Glyph glyph;
+    if (!bitmap.resolveGlyph(code, glyph))
+        return true; // Character is not in the font, so skip it.
+    uint8_t stride = (glyph.width + 7) >> 3;
+    uint16_t needed = stride * glyph.height;
+    if (needed > rowsSize)
+    {
+        uint8_t *newRows = (uint8_t *)realloc(rows, needed);
+        if (!newRows)
+            return true;
+        rows = newRows;
+        rowsSize = needed;
+    }
+    bitmap.rasterizeGlyph(glyph, rows);
+    glyphWidth = glyph.width;
+    glyphHeight = glyph.height;
+    glyphStride = stride;
+    blank = false;
+    return true;
+}
+
+void TextTicker::shiftLeft(Bitmap &bitmap, int x, int y, int width, int height)
+{
+    // Shift each row of the region left by one pixel, carrying the top bit
+    // of each byte into the byte to its left.
+    int stride = bitmap.getStride();
+    uint8_t *line = bitmap.getFrameBuffer() + y * stride + (x >> 3);
+    int lastByte = ((x + width - 1) >> 3) - (x >> 3);
+    uint8_t firstMask = 0xFF >> (x & 0x07);
+    uint8_t lastMask = 0xFF << (7 - ((x + width - 1) & 0x07));
+    while (height-- > 0)
+    {
+        for (int temp = 0; temp <= lastByte; ++temp)
+        {
+            uint8_t value = line[temp] << 1;
+            if (temp < lastByte)
+                value |= line[temp + 1] >> 7;
+            uint8_t mask = 0xFF;
+            if (temp == 0)
+                mask &= firstMask;
+            if (temp == lastByte)
+                mask &= lastMask;
+            line[temp] = (line[temp] & ~mask) | (value & mask);
+        }
+        line += stride;
+    }
+}
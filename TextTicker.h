@@ -0,0 +1,56 @@
+#ifndef TextTicker_h
+#define TextTicker_h
+
+#include "Bitmap.h"
+
+// Scrolls a stream of text of any length through a region of a Bitmap.
+// Characters are queued in a ring buffer as they arrive and each step
+// shifts the region left by one column and draws the single column of the
+// current glyph that scrolls into view, so a step costs the same however
+// long the text is.  The text is drawn in the bitmap's font, colour and
+// text scale.
+class TextTicker
+{
+public:
+    explicit TextTicker(uint16_t size = 128);
+    ~TextTicker();
+
+    bool isValid() const { return ring != 0; }
+
+    void setRegion(int x, int y, int width);
+
+    size_t write(uint8_t ch);
+    size_t write(const char *str, int len = -1);
+    int availableForWrite() const { return size - count; }
+
+    bool isIdle() const { return count == 0 && column >= (glyphWidth + 1) * glyphScale; }
+    void clear();
+
+    bool step(Bitmap &bitmap);
+
+private:
+    // Disable copy constructor and operator=().
+    TextTicker(const TextTicker &) {}
+    TextTicker &operator=(const TextTicker &) { return *this; }
+
+    char *ring;
+    uint16_t size;
+    uint16_t head;
+    uint16_t count;
+    uint8_t *rows;
+    uint16_t rowsSize;
+    uint8_t glyphWidth;
+    uint8_t glyphHeight;
+    uint8_t glyphStride;
+    uint8_t glyphScale;
+    uint16_t column;
+    bool blank;
+    int16_t regionX;
+    int16_t regionY;
+    int16_t regionWidth;
+
+    bool nextGlyph(Bitmap &bitmap);
+    static void shiftLeft(Bitmap &bitmap, int x, int y, int width, int height);
+};
+
+#endif
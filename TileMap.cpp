@@ -0,0 +1,152 @@
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "TileMap.h"
+#include "Bitmap.h"
+
+TileMap::TileMap(uint8_t columns, uint8_t rows)
+    : cells(0), glyphs(0), columns(columns), rows(rows), glyphHeight(0), glyphStride(0), cellWidth(0), cellHeight(0)
+{
+    cells = (uint8_t *)malloc(columns * rows);
+    if (cells)
+        clear();
+}
+
+TileMap::~TileMap()
+{
+    if (cells)
+        free(cells);
+    if (glyphs)
+        free(glyphs);
+}
+
+bool TileMap::setFont(const uint8_t *font)
+{
+    // Draw each character once into a scratch bitmap and keep its rows, so
+    // that a row of a cell is a table lookup while the display refreshes.
+    Bitmap measure(0, 0);
+    if (!font || !measure.setFont(font))
+        return false;
+    int width = 0;
+    for (int code = TILEMAP_FIRST_CHAR; code < (TILEMAP_FIRST_CHAR + TILEMAP_CHAR_COUNT); ++code)
+    {
+        int charWidth = measure.getCharWidth((char)code);
+        if (charWidth > width)
+            width = charWidth;
+    }
+    int height = measure.getTextHeight();
+    if (width <= 0 || width > TILEMAP_MAX_GLYPH_WIDTH || height <= 0 || height > TILEMAP_MAX_GLYPH_HEIGHT)
+        return false;
+    Bitmap scratch(width, height);
+    if (!scratch.isValid())
+        return false;
+    int stride = scratch.getStride();
+    uint8_t *table = (uint8_t *)malloc(TILEMAP_CHAR_COUNT * height * stride);
+    if (!table)
+        return false;
+    scratch.setFont(font);
+    uint8_t *dest = table;
+    for (int code = TILEMAP_FIRST_CHAR; code < (TILEMAP_FIRST_CHAR + TILEMAP_CHAR_COUNT); ++code)
+    {
+        // The frame buffer holds 1 for pixels that are off.
+        scratch.clearScreen();
+        scratch.drawChar(0, 0, (char)code);
+        const uint8_t *src = scratch.getFrameBuffer();
+        for (int posn = height * stride; posn > 0; --posn)
+            *dest++ = ~(*src++);
+    }
+    if (glyphs)
+        free(glyphs);
+    glyphs = table;
+    glyphHeight = height;
+    glyphStride = stride;
+    cellWidth = width + 1;
+    cellHeight = height + 1;
+    return true;
+}
+
+uint8_t TileMap::getCell(uint8_t column, uint8_t row) const
+{
+    if (!cells || column >= columns || row >= rows)
+        return 0;
+    return cells[row * columns + column];
+}
+
+void TileMap::setCell(uint8_t column, uint8_t row, uint8_t cell)
+{
+    if (cells && column < columns && row < rows)
+        cells[row * columns + column] = cell;
+}
+
+void TileMap::clear()
+{
+    if (cells)
+        memset(cells, ' ', columns * rows);
+}
+
+void TileMap::print(uint8_t column, uint8_t row, const char *str, uint8_t attrs)
+{
+    // Text is cut off at the end of the row.
+    if (!cells || row >= rows)
+        return;
+    uint8_t *cell = cells + row * columns + column;
+    while (*str && column < columns)
+    {
+        *cell++ = (((uint8_t)*str++) & 0x7F) | attrs;
+        ++column;
+    }
+}
+
+// ORs the 8 pixels in "value" into "row" at column "x", dropping those past
+// the end of the row.
+static inline void orByte(uint8_t *row, int bytes, int x, uint8_t value)
+{
+    int index = x >> 3;
+    uint8_t shift = x & 7;
+    if (index < bytes)
+        row[index] |= value >> shift;
+    if (shift && (index + 1) < bytes)
+        row[index + 1] |= value << (8 - shift);
+}
+
+void TileMap::renderRow(int y, uint8_t *row, int width) const
+{
+    int bytes = (width + 7) >> 3;
+    memset(row, 0, bytes);
+    if (!cells || !glyphs)
+        return;
+    int cellRow = y / cellHeight;
+    int glyphRow = y % cellHeight;
+    if (cellRow >= rows)
+        return;
+
+    // The rows of an inverted cell are lit across the gap column as well,
+    // and the bits of the glyph row are flipped over the cell's width.
+    const uint8_t *cell = cells + cellRow * columns;
+    int x = 0;
+    for (uint8_t column = 0; column < columns && x < width; ++column, x += cellWidth)
+    {
+        uint8_t ch = cell[column] & 0x7F;
+        bool invert = (cell[column] & TILEMAP_INVERT) != 0;
+        const uint8_t *src = 0;
+        if (glyphRow < glyphHeight && ch >= TILEMAP_FIRST_CHAR && ch < (TILEMAP_FIRST_CHAR + TILEMAP_CHAR_COUNT))
+            src = glyphs + ((ch - TILEMAP_FIRST_CHAR) * glyphHeight + glyphRow) * glyphStride;
+        if (!src && !invert)
+            continue;
+        int remaining = cellWidth;
+        for (uint8_t posn = 0; remaining > 0; ++posn, remaining -= 8)
+        {
+            uint8_t value = (src && posn < glyphStride) ? src[posn] : 0;
+            if (invert)
+                value = ~value & (remaining >= 8 ? 0xFF : (uint8_t)(0xFF << (8 - remaining)));
+            if (value)
+                orByte(row, bytes, x + posn * 8, value);
+        }
+    }
+}
+
+void TileMap::rowSource(int y, uint8_t *row, int width, void *context)
+{
+    ((const TileMap *)context)->renderRow(y, row, width);
+}
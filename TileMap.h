@@ -0,0 +1,72 @@
+#ifndef TileMap_h
+#define TileMap_h
+
+#include <inttypes.h>
+
+// Cell attribute: the cell is drawn as dark text on a lit background.
+#define TILEMAP_INVERT 0x80
+
+// Characters that have glyphs in the tile map.  Cells holding other
+// codes are blank.
+#define TILEMAP_FIRST_CHAR 32
+#define TILEMAP_CHAR_COUNT 96
+
+// Largest glyph the tile map takes, in pixels.
+#define TILEMAP_MAX_GLYPH_WIDTH 24
+#define TILEMAP_MAX_GLYPH_HEIGHT 32
+
+// A grid of character cells for text screens.  Each cell is one byte: an
+// ASCII code in the low seven bits and TILEMAP_INVERT, so changing a
+// character is a single write.  Rows of pixels are made from the cells
+// when the display asks for them in row mode, and no frame buffer is kept:
+//
+//     TileMap tiles(21, 2);
+//     DMDESP display(4, 1, TileMap::rowSource, &tiles);
+//     tiles.setFont(SystemFont5x7);
+//     tiles.print(0, 0, "HELLO");
+//
+// Cells are as wide as the widest glyph plus a one column gap and as high
+// as the font plus a one row gap, which suits the fixed-width fonts such
+// as Mono5x7 and SystemFont5x7.  The glyphs are copied into RAM one row
+// per byte, 672 bytes for a 5x7 font.
+class TileMap
+{
+public:
+    TileMap(uint8_t columns, uint8_t rows);
+    ~TileMap();
+
+    bool isValid() const { return cells != 0; }
+
+    uint8_t getColumns() const { return columns; }
+    uint8_t getRows() const { return rows; }
+    int getCellWidth() const { return cellWidth; }
+    int getCellHeight() const { return cellHeight; }
+
+    bool setFont(const uint8_t *font);
+
+    uint8_t *getCells() { return cells; }
+    uint8_t getCell(uint8_t column, uint8_t row) const;
+    void setCell(uint8_t column, uint8_t row, uint8_t cell);
+
+    void clear();
+    void print(uint8_t column, uint8_t row, const char *str, uint8_t attrs = 0);
+
+    void renderRow(int y, uint8_t *row, int width) const;
+    static void rowSource(int y, uint8_t *row, int width, void *context);
+
+private:
+    // Disable copy constructor and operator=().
+    TileMap(const TileMap &) {}
+    TileMap &operator=(const TileMap &) { return *this; }
+
+    uint8_t *cells;
+    uint8_t *glyphs;
+    uint8_t columns;
+    uint8_t rows;
+    uint8_t glyphHeight;
+    uint8_t glyphStride;
+    uint8_t cellWidth;
+    uint8_t cellHeight;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#include <DMDESP.h>
+#include <fonts/Arial14.h>
+#include <fonts/Droid_Sans_24.h>
+#include <fonts/SystemFont5x7.h>
+
+// Measures the CPU cycles taken to draw each glyph of a few fonts into an
+// off-screen bitmap and prints the averages to the serial port.
+
+#define ROUNDS 10
+
+Bitmap canvas(64, 32);
+
+void benchmark(const char *name, const uint8_t *font)
+{
+    canvas.setFont(font);
+    const FontInfo &info = canvas.getFontInfo();
+    uint32_t glyphs = 0;
+    uint32_t start = ESP.getCycleCount();
+    for (int round = 0; round < ROUNDS; ++round)
+    {
+        for (uint16_t ch = info.firstChar; ch < (info.firstChar + info.glyphCount); ++ch)
+        {
+            canvas.drawChar(3, 1, (char)ch);
+            ++glyphs;
+        }
+    }
+    uint32_t cycles = ESP.getCycleCount() - start;
+    Serial.print(name);
+    Serial.print(": ");
+    Serial.print(cycles / glyphs);
+    Serial.println(" cycles per glyph");
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    delay(100);
+    benchmark("SystemFont5x7", System5x7);
+    benchmark("Arial14", Arial14);
+    benchmark("Droid_Sans_24", Droid_Sans_24);
+}
+
+void loop()
+{
+}
@@ -49,7 +49,7 @@
 #define ARIAL_BLACK_16_WIDTH 10
 #define ARIAL_BLACK_16_HEIGHT 16
 
-static const uint8_t Arial_Black_16[] PROGMEM = {
+static constexpr uint8_t Arial_Black_16[] PROGMEM = {
     0x30, 0x86, // size
     0x0A, // width
     0x10, // height
@@ -46,7 +46,7 @@
 #define ARIAL_BLACK_16_ISO_8859_1_WIDTH 10
 #define ARIAL_BLACK_16_ISO_8859_1_HEIGHT 16
 
-const static uint8_t Arial_Black_16_ISO_8859_1[] PROGMEM = {
+static constexpr uint8_t Arial_Black_16_ISO_8859_1[] PROGMEM = {
     0x64, 0x36, // size
     0x0A, // width
     0x10, // height
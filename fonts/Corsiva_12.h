@@ -45,7 +45,7 @@
 #define CORSIVA_12_WIDTH 10
 #define CORSIVA_12_HEIGHT 11
 
-static uint8_t Corsiva_12[] PROGMEM = {
+static constexpr uint8_t Corsiva_12[] PROGMEM = {
     0x16, 0x3A, // size
     0x0A, // width
     0x0B, // height
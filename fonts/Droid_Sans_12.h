@@ -51,7 +51,7 @@
 #define DROID_SANS_12_WIDTH 10
 #define DROID_SANS_12_HEIGHT 12
 
-static const uint8_t Droid_Sans_12[] PROGMEM = {
+static constexpr uint8_t Droid_Sans_12[] PROGMEM = {
     0x15, 0xBA, // size
     0x0A, // width
     0x0C, // height
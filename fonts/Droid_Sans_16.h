@@ -51,7 +51,7 @@
 #define DROID_SANS_16_WIDTH 10
 #define DROID_SANS_16_HEIGHT 17
 
-static const uint8_t Droid_Sans_16[] PROGMEM = {
+static constexpr uint8_t Droid_Sans_16[] PROGMEM = {
     0x2A, 0x1A, // size
     0x0A, // width
     0x11, // height
@@ -51,7 +51,7 @@
 #define DROID_SANS_24_WIDTH 10
 #define DROID_SANS_24_HEIGHT 25
 
-static const uint8_t Droid_Sans_24[] PROGMEM = {
+static constexpr uint8_t Droid_Sans_24[] PROGMEM = {
     0x5C, 0xE1, // size
     0x0A, // width
     0x19, // height
@@ -51,7 +51,7 @@
 
 #define SystemFont5x7 System5x7
 
-static const uint8_t System5x7[] PROGMEM = {
+static constexpr uint8_t System5x7[] PROGMEM = {
     0x0, 0x0, // size of zero indicates fixed width font, actual length is width * height
     0x05, // width
     0x07, // height
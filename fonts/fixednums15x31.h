@@ -20,7 +20,7 @@
 #include <avr/pgmspace.h>
 
 
-static uint8_t fixednums15x31[] PROGMEM = {
+static constexpr uint8_t fixednums15x31[] PROGMEM = {
     0x0, 0x0,	// size of zero indicates fixed width font
     15,		// width
     31,		// height
@@ -18,7 +18,7 @@
 #include <avr/pgmspace.h>
 
 
-static uint8_t fixednums7x15[] PROGMEM = {
+static constexpr uint8_t fixednums7x15[] PROGMEM = {
     0x0, 0x0,	// size of zero indicates fixed width font
     7,		// width
     15,		// height
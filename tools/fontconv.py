@@ -0,0 +1,612 @@
+#!/usr/bin/env python3
+"""Convert FontCreator font headers and BDF fonts into DMDESP extended fonts.
+
+Usage: fontconv.py [options] input.h|input.bdf [output.h|output.fnt]
+
+--chars, --text and --scan cut the font down to the characters that are
+needed.  --scan reads the string and character literals of C and C++
+sources, so a font can be made for exactly what a sketch displays:
+
+    fontconv.py --scan MySign.ino fonts/Arial14.h Arial14_Sign.h
+
+The input is one of the fonts/*.h headers or a BDF font.  The output is a
+header that declares a PROGMEM array in the extended font format
+understood by Bitmap::setFont():
+
+    uint8_t  marker;        // 0xFF, never the start of a FontCreator font
+    uint8_t  encoding;      // 0 = column-major, 1 = row-major, 2 = packed
+    uint8_t  width;         // nominal width, as in FontCreator fonts
+    uint8_t  height;
+    uint8_t  firstChar;
+    uint8_t  charCount;
+    uint8_t  flags;         // bit 0 = fixed width, bit 1 = ranges, bit 2 = map
+    uint8_t  baseline;      // rows from the top to the baseline, 0 = unknown
+    uint16_t offsets[charCount + 1];    // little-endian, from font start
+    uint8_t  widths[charCount];
+    uint8_t  data[];
+
+Fonts whose characters are not one run of codes below 256 set the ranges
+flag.  The header is then followed by the glyph count, the range count
+and a table of ranges, each a uint32 first code point, uint16 count and
+uint16 first glyph index.  The glyph count replaces charCount above.
+
+Fonts whose characters are below 256 but not one run set the map flag
+instead.  firstChar and charCount then cover the codes from the first
+character to the last, and the header is followed by a uint8 glyph count
+and a byte for each of those codes giving its glyph, or 0xFF if there is
+no glyph.  The glyph count replaces charCount in the tables that follow,
+and glyphs are found by indexing the map rather than searching ranges.
+
+An output name ending in .fnt writes the font's bytes alone, with no C
+around them, for loading from LittleFS with FileFont instead of PROGMEM.
+
+The glyph offsets are computed here so that setFont() never has to scan
+the font to find a glyph.
+
+In the column-major encoding each glyph is stored as in FontCreator
+fonts: (height + 7) / 8 rows of bytes, each row holding one byte per
+column with the top pixel in bit 0.  For heights that are not a multiple
+of 8 the last row of bytes is aligned with the bottom of the glyph.
+
+In the row-major encoding each glyph is stored as "height" rows of
+(width + 7) / 8 bytes, most significant bit first, 1 = pixel on.  This is
+the same layout as a Bitmap's frame buffer so glyphs can be blitted a row
+at a time.
+
+In the packed encoding each glyph is a stream of bits, most significant
+bit first.  It starts with the top row and height of the smallest box
+around the glyph's pixels, each height.bit_length() bits, and the left
+column and width of the box, each glyph_width.bit_length() bits.  The
+pixels of the box follow row by row with no padding.  Blank rows and
+columns take no space at all.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+EXT_MARKER = 0xFF
+ENCODING_COLUMN_MAJOR = 0
+ENCODING_ROW_MAJOR = 1
+ENCODING_PACKED = 2
+FLAG_FIXED_WIDTH = 0x01
+FLAG_RANGES = 0x02
+FLAG_MAP = 0x04
+MAP_NONE = 0xFF
+HEADER_SIZE = 8
+RANGE_SIZE = 8
+
+ENCODINGS = {
+    'colmajor': ENCODING_COLUMN_MAJOR,
+    'rowmajor': ENCODING_ROW_MAJOR,
+    'packed': ENCODING_PACKED,
+}
+
+
+class Glyph:
+    def __init__(self, width, rows):
+        self.width = width
+        self.rows = rows    # One int per row, bit (width - 1) is the left pixel.
+
+
+class Font:
+    def __init__(self, name, width, height, glyphs, fixed, baseline=0):
+        self.name = name
+        self.width = width
+        self.height = height
+        self.glyphs = glyphs    # Glyph for each code point.
+        self.fixed = fixed
+        self.baseline = baseline    # 0 if unknown.
+
+    def ranges(self):
+        """Returns (first code, count) for each run of consecutive codes."""
+        result = []
+        for code in sorted(self.glyphs):
+            if result and result[-1][0] + result[-1][1] == code:
+                result[-1][1] += 1
+            else:
+                result.append([code, 1])
+        return result
+
+
+def parse_c_bytes(text):
+    """Returns the name and contents of the first PROGMEM byte array."""
+    text = re.sub(r'/\*.*?\*/', ' ', text, flags=re.S)
+    text = re.sub(r'//[^\n]*', ' ', text)
+    match = re.search(r'(\w+)\s*\[\s*\]\s*PROGMEM\s*=\s*\{(.*?)\}', text, re.S)
+    if not match:
+        raise ValueError('no PROGMEM array found')
+    values = []
+    for token in match.group(2).split(','):
+        token = token.strip()
+        if not token:
+            continue
+        if token.startswith("'"):
+            values.append(ord(token[1:-1].encode().decode('unicode_escape')))
+        else:
+            values.append(int(token, 0))
+    return match.group(1), values
+
+
+def load_fontcreator(path):
+    with open(path) as f:
+        name, data = parse_c_bytes(f.read())
+    fixed = data[0] == 0 and data[1] == 0
+    width = data[2]
+    height = data[3]
+    first_char = data[4]
+    char_count = data[5]
+    height_bytes = (height + 7) >> 3
+    if fixed:
+        widths = [width] * char_count
+        posn = 6
+    else:
+        widths = data[6:6 + char_count]
+        posn = 6 + char_count
+    glyphs = {}
+    for code, char_width in enumerate(widths, first_char):
+        rows = [0] * height
+        for cx in range(char_width):
+            for cy in range(height_bytes):
+                value = data[posn + cy * char_width + cx] if posn + cy * char_width + cx < len(data) else 0
+                # The last byte of a column is aligned with the bottom of
+                # the glyph rather than padded, just as drawChar() reads it.
+                if height_bytes > 1 and cy == height_bytes - 1:
+                    base = height - 8
+                else:
+                    base = cy * 8
+                for bit in range(8):
+                    y = base + bit
+                    if y >= cy * 8 and y < height and value & (1 << bit):
+                        rows[y] |= 1 << (char_width - 1 - cx)
+        glyphs[code] = Glyph(char_width, rows)
+        posn += char_width * height_bytes
+    return Font(name, width, height, glyphs, fixed)
+
+
+def load_bdf(path):
+    """Loads a BDF font, placing each glyph in a cell of the font's height."""
+    with open(path) as f:
+        lines = f.read().splitlines()
+    ascent = descent = None
+    box = None
+    glyphs = {}
+    posn = 0
+    while posn < len(lines):
+        words = lines[posn].split()
+        posn += 1
+        if not words:
+            continue
+        if words[0] == 'FONTBOUNDINGBOX':
+            box = [int(v) for v in words[1:5]]
+        elif words[0] == 'FONT_ASCENT':
+            ascent = int(words[1])
+        elif words[0] == 'FONT_DESCENT':
+            descent = int(words[1])
+        elif words[0] == 'STARTCHAR':
+            code = -1
+            advance = 0
+            bbx = [0, 0, 0, 0]
+            while posn < len(lines):
+                words = lines[posn].split()
+                posn += 1
+                if not words:
+                    continue
+                if words[0] == 'ENCODING':
+                    code = int(words[1])
+                elif words[0] == 'DWIDTH':
+                    advance = int(words[1])
+                elif words[0] == 'BBX':
+                    bbx = [int(v) for v in words[1:5]]
+                elif words[0] == 'BITMAP':
+                    break
+            bitmap = []
+            while posn < len(lines) and lines[posn].strip() != 'ENDCHAR':
+                bitmap.append(lines[posn].strip())
+                posn += 1
+            posn += 1
+            if code >= 0:
+                glyphs[code] = (advance, bbx, bitmap)
+    if ascent is None or descent is None:
+        if box is None:
+            raise ValueError('BDF font has no FONT_ASCENT or FONTBOUNDINGBOX')
+        ascent = box[1] + box[3]
+        descent = -box[3]
+    height = ascent + descent
+    if not 0 < height < 256:
+        raise ValueError('font height %d is out of range' % height)
+
+    # Glyphs that hang left of the origin or past the advance width are
+    # widened, since DMDESP draws each glyph within its own cell.
+    result = {}
+    for code, (advance, bbx, bitmap) in glyphs.items():
+        box_width, box_height, box_x, box_y = bbx
+        left = min(0, box_x)
+        width = max(advance, box_x + box_width) - left
+        if width > 255:
+            raise ValueError('glyph %d is too wide' % code)
+        rows = [0] * height
+        top = ascent - (box_y + box_height)
+        for row, text in enumerate(bitmap[:box_height]):
+            y = top + row
+            if not 0 <= y < height or not text:
+                continue
+            value = int(text, 16) >> (len(text) * 4 - box_width)
+            rows[y] = value << (width - (box_x - left) - box_width)
+        result[code] = Glyph(width, rows)
+    widths = set(glyph.width for glyph in result.values())
+    name = re.sub(r'\W', '_', os.path.splitext(os.path.basename(path))[0])
+    return Font(name, max(widths), height, result, len(widths) == 1, ascent)
+
+
+def parse_chars(spec):
+    """Parses a list of codes and ranges such as "32-126,0xA0-0xFF,0x20AC"."""
+    codes = set()
+    for item in spec.split(','):
+        item = item.strip()
+        if not item:
+            continue
+        if '-' in item:
+            first, last = item.split('-', 1)
+            codes.update(range(int(first, 0), int(last, 0) + 1))
+        else:
+            codes.add(int(item, 0))
+    return codes
+
+
+def decode_utf8(data):
+    """Decodes bytes as Bitmap::decodeUtf8() does.
+
+    Bytes that do not start a valid UTF-8 sequence are Latin-1 characters.
+    """
+    codes = []
+    posn = 0
+    while posn < len(data):
+        ch = data[posn]
+        posn += 1
+        if ch < 0xC2 or ch > 0xF4:
+            codes.append(ch)
+            continue
+        extra = 3 if ch >= 0xF0 else (2 if ch >= 0xE0 else 1)
+        tail = data[posn:posn + extra]
+        if len(tail) < extra or any((b & 0xC0) != 0x80 for b in tail):
+            codes.append(ch)
+            continue
+        code = ch & (0x3F >> extra)
+        for b in tail:
+            code = (code << 6) | (b & 0x3F)
+        codes.append(code)
+        posn += extra
+    return codes
+
+
+SOURCE_TOKEN = re.compile(
+    rb'//[^\n]*|/\*.*?\*/|^[ \t]*#[ \t]*include[^\n]*|'
+    rb'"((?:\\.|[^"\\\n])*)"|\'((?:\\.|[^\'\\\n])*)\'',
+    re.S | re.M)
+
+SIMPLE_ESCAPES = {
+    ord('a'): 7, ord('b'): 8, ord('f'): 12, ord('n'): 10,
+    ord('r'): 13, ord('t'): 9, ord('v'): 11,
+}
+
+
+def unescape_literal(body):
+    """Returns the bytes of the body of a C string or character literal."""
+    out = bytearray()
+    posn = 0
+    while posn < len(body):
+        ch = body[posn]
+        posn += 1
+        if ch != ord('\\') or posn >= len(body):
+            out.append(ch)
+            continue
+        ch = body[posn]
+        posn += 1
+        if ch == ord('x'):
+            digits = re.match(rb'[0-9A-Fa-f]*', body[posn:]).group()
+            out.append(int(digits or b'0', 16) & 0xFF)
+            posn += len(digits)
+        elif ord('0') <= ch <= ord('7'):
+            digits = re.match(rb'[0-7]{0,2}', body[posn:]).group()
+            out.append(int(bytes([ch]) + digits, 8) & 0xFF)
+            posn += len(digits)
+        elif ch in (ord('u'), ord('U')):
+            size = 4 if ch == ord('u') else 8
+            out.extend(chr(int(body[posn:posn + size], 16)).encode('utf-8'))
+            posn += size
+        else:
+            out.append(SIMPLE_ESCAPES.get(ch, ch))
+    return bytes(out)
+
+
+def scan_source(path):
+    """Returns the printable code points used by the literals in a source file.
+
+    Sources are taken to be UTF-8, as they are for the ESP8266 compiler.
+    Comments and #include lines are skipped.
+    """
+    with open(path, 'rb') as f:
+        text = f.read()
+    codes = set()
+    for match in SOURCE_TOKEN.finditer(text):
+        body = match.group(1) if match.group(1) is not None else match.group(2)
+        if body is not None:
+            codes.update(decode_utf8(unescape_literal(body)))
+    return set(code for code in codes if code >= 0x20 and code != 0x7F)
+
+
+def encode_column_major(glyph, height):
+    height_bytes = (height + 7) >> 3
+    out = []
+    for cy in range(height_bytes):
+        # The last row of bytes is aligned with the bottom of the glyph.
+        base = height - 8 if height_bytes > 1 and cy == height_bytes - 1 else cy * 8
+        for cx in range(glyph.width):
+            mask = 1 << (glyph.width - 1 - cx)
+            value = 0
+            for bit in range(8):
+                y = base + bit
+                if y < height and glyph.rows[y] & mask:
+                    value |= 1 << bit
+            out.append(value)
+    return out
+
+
+def encode_row_major(glyph, height):
+    stride = (glyph.width + 7) >> 3
+    out = []
+    for y in range(height):
+        value = glyph.rows[y] << (stride * 8 - glyph.width)
+        out.extend((value >> (8 * (stride - 1 - i))) & 0xFF for i in range(stride))
+    return out
+
+
+def encode_packed(glyph, height):
+    lit = [y for y in range(height) if glyph.rows[y]]
+    top = bottom = left = right = 0
+    if lit:
+        top = lit[0]
+        bottom = lit[-1] + 1
+        mask = 0
+        for y in lit:
+            mask |= glyph.rows[y]
+        left = glyph.width - mask.bit_length()
+        right = glyph.width - ((mask & -mask).bit_length() - 1)
+    box_width = right - left
+    height_bits = height.bit_length()
+    width_bits = glyph.width.bit_length()
+    bits = []
+
+    def put(value, count):
+        bits.extend((value >> (count - 1 - i)) & 1 for i in range(count))
+
+    put(top, height_bits)
+    put(bottom - top, height_bits)
+    put(left, width_bits)
+    put(box_width, width_bits)
+    for y in range(top, bottom):
+        put(glyph.rows[y] >> (glyph.width - right), box_width)
+    bits.extend([0] * (-len(bits) % 8))
+    out = []
+    for start in range(0, len(bits), 8):
+        byte = 0
+        for bit in bits[start:start + 8]:
+            byte = (byte << 1) | bit
+        out.append(byte)
+    return out
+
+
+def encode_font(font, encoding):
+    encoder = {
+        ENCODING_COLUMN_MAJOR: encode_column_major,
+        ENCODING_ROW_MAJOR: encode_row_major,
+        ENCODING_PACKED: encode_packed,
+    }[encoding]
+    codes = sorted(font.glyphs)
+    count = len(codes)
+    ranges = font.ranges()
+    span = codes[-1] - codes[0] + 1
+    use_map = len(ranges) != 1 and span <= 255 and count < MAP_NONE and codes[-1] <= 0xFF
+    use_ranges = not use_map and (len(ranges) != 1 or codes[-1] > 255 or count > 255)
+    flags = FLAG_FIXED_WIDTH if font.fixed else 0
+    header = [EXT_MARKER, encoding, font.width, font.height]
+    table = []
+    if use_ranges:
+        flags |= FLAG_RANGES
+        header.extend((0, 0, flags, font.baseline))
+        table.extend(le16(count) + le16(len(ranges)))
+        glyph = 0
+        for first, run in ranges:
+            table.extend(le32(first) + le16(run) + le16(glyph))
+            glyph += run
+    elif use_map:
+        flags |= FLAG_MAP
+        header.extend((codes[0], span, flags, font.baseline))
+        table.append(count)
+        glyph_map = [MAP_NONE] * span
+        for index, code in enumerate(codes):
+            glyph_map[code - codes[0]] = index
+        table.extend(glyph_map)
+    else:
+        header.extend((codes[0], count, flags, font.baseline))
+    glyph_data = [encoder(font.glyphs[code], font.height) for code in codes]
+    offset = HEADER_SIZE + len(table) + 2 * (count + 1) + count
+    offsets = []
+    for data in glyph_data:
+        offsets.append(offset)
+        offset += len(data)
+    offsets.append(offset)
+    if offset > 0xFFFF:
+        raise ValueError('font is too large for 16-bit glyph offsets')
+    for value in offsets:
+        table.extend(le16(value))
+    widths = [font.glyphs[code].width for code in codes]
+    return header, table, widths, glyph_data
+
+
+def le16(value):
+    return [value & 0xFF, (value >> 8) & 0xFF]
+
+
+def le32(value):
+    return le16(value & 0xFFFF) + le16(value >> 16)
+
+
+def char_comment(code):
+    if 0x20 < code < 0x7F and chr(code) not in "\\'":
+        return "'%s'" % chr(code)
+    if code > 0xFF:
+        return 'U+%04X' % code
+    return str(code)
+
+
+def format_bytes(values, indent='    '):
+    lines = []
+    for start in range(0, len(values), 12):
+        chunk = values[start:start + 12]
+        lines.append(indent + ', '.join('0x%02X' % v for v in chunk) + ',')
+    return lines
+
+
+def write_header(font, encoding_name, source, out):
+    header, table, widths, glyph_data = encode_font(font, ENCODINGS[encoding_name])
+    size = len(header) + len(table) + len(widths) + sum(len(d) for d in glyph_data)
+    codes = sorted(font.glyphs)
+    guard = font.name.upper() + '_H'
+    lines = [
+        '',
+        '/*',
+        ' *',
+        ' * %s' % font.name,
+        ' *',
+        ' * Generated by tools/fontconv.py from %s' % source,
+        ' *',
+        ' * Encoding            : %s' % encoding_name,
+        ' * Font size in bytes  : %d' % size,
+        ' * Font width          : %d' % font.width,
+        ' * Font height         : %d' % font.height,
+        ' * Font baseline       : %s' % (font.baseline or 'unknown'),
+        ' * Font first char     : %d' % codes[0],
+        ' * Font last char      : %d' % (codes[-1] + 1),
+        ' * Font used chars     : %d' % len(codes),
+        ' */',
+        '',
+        '#include <inttypes.h>',
+        '#ifdef __AVR__',
+        '#include <avr/pgmspace.h>',
+        '#elif defined (ESP8266)',
+        '#include <pgmspace.h>',
+        '#else',
+        '#define PROGMEM',
+        '#endif',
+        '',
+        '#ifndef %s' % guard,
+        '#define %s' % guard,
+        '',
+        'static constexpr uint8_t %s[] PROGMEM = {' % font.name,
+        '    0x%02X, 0x%02X, // marker, encoding' % (header[0], header[1]),
+        '    0x%02X, // width' % header[2],
+        '    0x%02X, // height' % header[3],
+        '    0x%02X, // first char' % header[4],
+        '    0x%02X, // char count' % header[5],
+        '    0x%02X, 0x%02X, // flags, baseline' % (header[6], header[7]),
+        '',
+    ]
+    if header[6] & FLAG_RANGES:
+        ranges = len(font.ranges())
+        lines.append('    // glyph count, range count, ranges')
+        lines.extend(format_bytes(table[:4 + ranges * RANGE_SIZE]))
+        table = table[4 + ranges * RANGE_SIZE:]
+        lines.append('')
+    elif header[6] & FLAG_MAP:
+        lines.append('    // glyph count, glyph of each char')
+        lines.extend(format_bytes(table[:1 + header[5]]))
+        table = table[1 + header[5]:]
+        lines.append('')
+    lines.append('    // glyph offsets')
+    lines.extend(format_bytes(table))
+    lines.append('')
+    lines.append('    // char widths')
+    lines.extend(format_bytes(widths))
+    lines.append('')
+    lines.append('    // font data')
+    for code, data in zip(codes, glyph_data):
+        lines.append('    // %s' % char_comment(code))
+        lines.extend(format_bytes(data))
+    lines.append('};')
+    lines.append('')
+    lines.append('#endif')
+    lines.append('')
+    out.write('\n'.join(lines))
+
+
+def write_binary(font, encoding_name, out):
+    header, table, widths, glyph_data = encode_font(font, ENCODINGS[encoding_name])
+    out.write(bytes(header + table + widths))
+    for data in glyph_data:
+        out.write(bytes(data))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert fonts for DMDESP.')
+    parser.add_argument('input', help='FontCreator header from fonts/, or a BDF font')
+    parser.add_argument('output', nargs='?',
+                        help='output header, or .fnt file of raw font bytes (default: stdout)')
+    parser.add_argument('--encoding', choices=sorted(ENCODINGS), default='rowmajor',
+                        help='glyph encoding of the output font')
+    parser.add_argument('--name', help='name of the output array')
+    parser.add_argument('--chars', help='characters to keep, e.g. "32-126,0xB0"')
+    parser.add_argument('--text', help='keep the characters of this text')
+    parser.add_argument('--scan', action='append', default=[], metavar='SOURCE',
+                        help='keep the characters used by literals in this C/C++ '
+                             'source; may be given more than once')
+    parser.add_argument('--base', type=lambda v: int(v, 0),
+                        help='move the first character to this code point')
+    parser.add_argument('--baseline', type=int,
+                        help='rows from the top of the font to the baseline')
+    args = parser.parse_args()
+
+    bdf = args.input.lower().endswith('.bdf')
+    font = load_bdf(args.input) if bdf else load_fontcreator(args.input)
+    if args.baseline is not None:
+        font.baseline = args.baseline
+    if args.chars or args.text or args.scan:
+        # Characters the text needs are reported if the font lacks them.
+        used = set(ord(ch) for ch in args.text or '')
+        for path in args.scan:
+            used.update(scan_source(path))
+        keep = used | (parse_chars(args.chars) if args.chars else set())
+        if ord(' ') in keep and ord('n') not in keep and ord('n') in font.glyphs:
+            # Spaces are drawn as wide as 'n', which the subset leaves out,
+            # so keep that width in a blank space glyph.
+            font.glyphs[ord(' ')] = Glyph(font.glyphs[ord('n')].width, [0] * font.height)
+        missing = sorted(used - set(font.glyphs))
+        if missing:
+            sys.stderr.write('%s: no glyphs for %s\n' % (
+                args.input, ', '.join(char_comment(code) for code in missing)))
+        font.glyphs = dict((code, glyph) for code, glyph in font.glyphs.items() if code in keep)
+    if args.base is not None and font.glyphs:
+        delta = args.base - min(font.glyphs)
+        font.glyphs = dict((code + delta, glyph) for code, glyph in font.glyphs.items())
+    if not font.glyphs:
+        parser.error('no characters left in the font')
+    if args.name:
+        font.name = args.name
+    elif not bdf:
+        # Keep the name apart from the FontCreator font's own array.
+        font.name += {'colmajor': '_CM', 'rowmajor': '_RM', 'packed': '_PK'}[args.encoding]
+    source = os.path.basename(args.input)
+    if args.output and args.output.lower().endswith('.fnt'):
+        with open(args.output, 'wb') as out:
+            write_binary(font, args.encoding, out)
+    elif args.output:
+        with open(args.output, 'w') as out:
+            write_header(font, args.encoding, source, out)
+    else:
+        write_header(font, args.encoding, source, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()